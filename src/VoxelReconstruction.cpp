@@ -10,13 +10,20 @@
 #include <opencv2/highgui/highgui.hpp>
 #include <opencv2/highgui/highgui_c.h>
 #include <stddef.h>
+#include <algorithm>
 #include <cassert>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <sstream>
+#include <thread>
 
+#include "controllers/FramePipeline.h"
 #include "controllers/Glut.h"
 #include "controllers/Reconstructor.h"
 #include "controllers/Scene3DRenderer.h"
+#include "controllers/VoxelWriter.h"
 #include "utilities/General.h"
 
 using namespace nl_uu_science_gmt;
@@ -26,6 +33,42 @@ using namespace cv;
 namespace nl_uu_science_gmt
 {
 
+namespace
+{
+
+/*
+ * Parse a comma separated list of integers
+ */
+bool parseInts(
+		const char* text, vector<int> &values)
+{
+	values.clear();
+	stringstream ss(text);
+	string item;
+	while (getline(ss, item, ','))
+	{
+		char* end;
+		const long value = strtol(item.c_str(), &end, 10);
+		if (item.empty() || *end != '\0') return false;
+		values.push_back((int) value);
+	}
+	return !values.empty();
+}
+
+/*
+ * Print the average duration and the throughput of a stage over the given frames
+ */
+void printStage(
+		const string &stage, double busy_time, size_t frames)
+{
+	cout << stage << ": " << (frames > 0 ? busy_time / frames : 0) << " ms/frame, "
+			<< (busy_time > 0 ? 1000.0 * frames / busy_time : 0) << " frames/s" << endl;
+}
+
+} /* namespace */
+
+const double VoxelReconstruction::DEFAULT_FRAME_CACHE = 256;
+
 /**
  * Main constructor, initialized all cameras
  */
@@ -89,14 +132,69 @@ void VoxelReconstruction::showKeys()
 	cout << "r       : Rotate voxel space" << endl;
 	cout << "s       : Show/hide arcball wire sphere (Linux only)" << endl;
 	cout << "v       : Show/hide voxel space box" << endl;
+	cout << "x       : Show voxels as cubes (surface only) or points (Linux only)" << endl;
 	cout << "g       : Show/hide ground plane" << endl;
 	cout << "c       : Show/hide cameras" << endl;
 	cout << "i       : Show/hide camera numbers (Linux only)" << endl;
 	cout << "o       : Show/hide origin" << endl;
 	cout << "t       : Top view" << endl;
+	cout << "m       : Switch voxel carving mode (compares all modes on the current frame)" << endl;
 	cout << "1,2,3,4 : Switch camera #" << endl << endl;
 	cout << "Zoom with the scrollwheel while on the 3D scene" << endl;
 	cout << "Rotate the 3D scene with left click+drag" << endl << endl;
+	cout << "Command line options (override data/" << General::VolumeConfigFile << "):" << endl;
+	cout << "--volume xmin,ymin,zmin,xmax,ymax,zmax : Voxel volume bounds (mm)" << endl;
+	cout << "--step s | sx,sy,sz                    : Voxel step size (mm)" << endl;
+	cout << "--memory-budget MB                     : Maximum voxel memory, 0 = unlimited" << endl;
+	cout << "--no-downscale                         : Refuse a volume over budget instead of coarsening it" << endl;
+	cout << "--serial                               : Decode, segment, carve and render each frame in turn" << endl;
+	cout << "--frame-cache MB                       : Memory for decoded frames of all cameras (default "
+			<< DEFAULT_FRAME_CACHE << "), 0 = off" << endl;
+	cout << "--predecode                            : Decode the videos once into frame files and play from those" << endl;
+	cout << "--source s                             : Frame source: auto (pre-decoded frames, else video; default)," << endl;
+	cout << "                                         video, images (camN/" << General::ImageSequencePattern
+			<< "), raw or synthetic" << endl;
+	cout << "--thresholds h,s,v                     : Background subtraction thresholds, instead of determining them" << endl;
+	cout << "--data path                            : Data path (default data" << PATH_SEP << ")" << endl;
+	cout << "--cameras n                            : Amount of cameras (default 4)" << endl << endl;
+	cout << "Headless batch mode (no windows, needs calibrated cameras and --thresholds):" << endl;
+	cout << "--headless                             : Reconstruct the frames as fast as possible and print the throughput" << endl;
+	cout << "--frames first,last                    : Frame range (default all)" << endl;
+	cout << "--output directory                     : Write every frame's voxels to directory/voxels_#####.ply" << endl << endl;
+}
+
+/**
+ * Override the volume settings with the ones given on the command line
+ */
+bool VoxelReconstruction::parseVolumeArguments(
+		int argc, char** argv, Reconstructor::Volume &volume)
+{
+	for (int a = 1; a < argc; ++a)
+	{
+		const bool has_value = a + 1 < argc;
+		vector<int> values;
+		if (strcmp(argv[a], "--volume") == 0 && has_value)
+		{
+			if (!parseInts(argv[++a], values) || values.size() != 6) return false;
+			volume.min = Point3i(values[0], values[1], values[2]);
+			volume.max = Point3i(values[3], values[4], values[5]);
+		}
+		else if (strcmp(argv[a], "--step") == 0 && has_value)
+		{
+			if (!parseInts(argv[++a], values) || (values.size() != 1 && values.size() != 3)) return false;
+			volume.step = values.size() == 1 ? Point3i(values[0], values[0], values[0]) : Point3i(values[0], values[1], values[2]);
+		}
+		else if (strcmp(argv[a], "--memory-budget") == 0 && has_value)
+		{
+			volume.memory_budget = atof(argv[++a]);
+		}
+		else if (strcmp(argv[a], "--no-downscale") == 0)
+		{
+			volume.downscale = false;
+		}
+	}
+
+	return true;
 }
 
 /**
@@ -104,24 +202,165 @@ void VoxelReconstruction::showKeys()
  *   create it from the checkerboard video and the measured camera intrinsics
  * - After that initialize the scene rendering classes
  * - Run it!
+ * Returns false if an option is malformed or the cameras, the voxel space or a
+ * headless run failed
  */
-void VoxelReconstruction::run(int argc, char** argv)
+bool VoxelReconstruction::run(int argc, char** argv)
 {
+	// Frame source of the cameras
+	Camera::FrameSourceType source_type = Camera::SOURCE_AUTO;
+	for (int a = 1; a + 1 < argc; ++a)
+	{
+		if (strcmp(argv[a], "--source") != 0) continue;
+
+		int type = 0;
+		while (type < Camera::SOURCE_TYPES
+				&& strcmp(argv[a + 1], Camera::getSourceTypeName((Camera::FrameSourceType) type)) != 0)
+			++type;
+		if (type == Camera::SOURCE_TYPES)
+		{
+			cerr << "Unknown frame source: " << argv[a + 1] << endl;
+			return false;
+		}
+		source_type = (Camera::FrameSourceType) type;
+	}
+
+	// Headless batch mode: no windows, so the thresholds can't be determined interactively
+	bool headless = false;
+	vector<int> thresholds, range;
+	string output;
+	for (int a = 1; a < argc; ++a)
+	{
+		const bool has_value = a + 1 < argc;
+		if (strcmp(argv[a], "--headless") == 0)
+		{
+			headless = true;
+		}
+		else if (strcmp(argv[a], "--thresholds") == 0 && has_value)
+		{
+			if (!parseInts(argv[++a], thresholds) || thresholds.size() != 3)
+			{
+				cerr << "Malformed thresholds, expected h,s,v" << endl;
+				return false;
+			}
+		}
+		else if (strcmp(argv[a], "--frames") == 0 && has_value)
+		{
+			if (!parseInts(argv[++a], range) || range.size() != 2)
+			{
+				cerr << "Malformed frame range, expected first,last" << endl;
+				return false;
+			}
+		}
+		else if (strcmp(argv[a], "--output") == 0 && has_value)
+		{
+			output = argv[++a];
+		}
+	}
+	if (headless && thresholds.empty())
+	{
+		cerr << "Headless mode needs --thresholds h,s,v" << endl;
+		return false;
+	}
+
+	for (int v = 0; v < m_cam_views_amount; ++v)
+	{
+		m_cam_views[v]->setFrameSourceType(source_type);
+
+		// Calibrating shows the checkerboard, so a headless run uses the existing calibration
+		const string &data_path = m_cam_views[v]->getDataPath();
+		bool has_cam = headless ?
+				General::fexists(data_path + m_cam_views[v]->getCamPropertiesFile()) :
+				Camera::detExtrinsics(data_path, General::CheckerboadVideo, General::IntrinsicsFile,
+						m_cam_views[v]->getCamPropertiesFile());
+		if (!has_cam && headless)
+		{
+			cerr << "Camera " << v + 1 << " is not calibrated: " << data_path << m_cam_views[v]->getCamPropertiesFile()
+					<< " is missing" << endl;
+			return false;
+		}
+		if (!has_cam || !m_cam_views[v]->initialize())
+		{
+			cerr << "Unable to initialize camera " << v + 1 << ": " << data_path << endl;
+			return false;
+		}
+	}
+
+	// Volume settings from the data path's XML file, then from the command line
+	Reconstructor::Volume volume;
+	Reconstructor::readVolume(m_data_path + General::VolumeConfigFile, volume);
+	if (!parseVolumeArguments(argc, argv, volume))
+	{
+		cerr << "Malformed voxel volume arguments" << endl;
+		return false;
+	}
+	if (!Reconstructor::fitVolume(volume, m_cam_views)) return false;
+
+	// Decode the videos once into frame files to play back from, the cameras in parallel
+	bool predecode = false;
+	for (int a = 1; a < argc; ++a)
+		predecode = predecode || strcmp(argv[a], "--predecode") == 0;
+	if (predecode)
+	{
+		cout << "Pre-decoding the videos" << endl;
+		int v;
+#pragma omp parallel for schedule(dynamic) private(v)
+		for (v = 0; v < m_cam_views_amount; ++v)
+			m_cam_views[v]->predecodeVideo();
+	}
+	for (int v = 0; v < m_cam_views_amount; ++v)
+		cout << "Camera " << v + 1 << " reads " << m_cam_views[v]->getFramesAmount() << " frames from its "
+				<< m_cam_views[v]->getFrameSource().getName() << endl;
+
+	// Decoded frame cache, the budget is shared by the cameras
+	double frame_cache = DEFAULT_FRAME_CACHE;
+	for (int a = 1; a + 1 < argc; ++a)
+		if (strcmp(argv[a], "--frame-cache") == 0) frame_cache = atof(argv[a + 1]);
 	for (int v = 0; v < m_cam_views_amount; ++v)
+		m_cam_views[v]->setFrameCacheBudget((size_t) (std::max(0.0, frame_cache) * 1024 * 1024 / m_cam_views_amount));
+	cout << "Caching " << m_cam_views.front()->getFrameCache().getCapacity() << " decoded frames per camera" << endl;
+
+	Reconstructor reconstructor(m_cam_views, volume);
+	if (reconstructor.getVoxels().size() == 0)
 	{
-		bool has_cam = Camera::detExtrinsics(m_cam_views[v]->getDataPath(), General::CheckerboadVideo,
-				General::IntrinsicsFile, m_cam_views[v]->getCamPropertiesFile());
-		assert(has_cam);
-		if (has_cam) has_cam = m_cam_views[v]->initialize();
-		assert(has_cam);
+		cerr << "No voxel of the volume is in view of all cameras" << endl;
+		return false;
+	}
+	Scene3DRenderer scene3d(reconstructor, m_cam_views);
+	if (!thresholds.empty()) scene3d.setThresholds(thresholds[0], thresholds[1], thresholds[2]);
+
+	if (headless)
+	{
+		// The pipeline wraps after frame amount - 2, like the interactive loop
+		const int last_frame = (int) scene3d.getNumberOfFrames() - 2;
+		const int first = range.empty() ? 0 : range[0];
+		const int last = range.empty() ? last_frame : range[1];
+		if (first < 0 || first > last || last > last_frame)
+		{
+			cerr << "Frame range " << first << "," << last << " is outside 0," << last_frame << endl;
+			return false;
+		}
+		return runBatch(scene3d, first, last, output);
 	}
 
 	destroyAllWindows();
 	namedWindow(VIDEO_WINDOW, CV_WINDOW_KEEPRATIO);
+	scene3d.createTrackbars();
 
-	Reconstructor reconstructor(m_cam_views);
-	Scene3DRenderer scene3d(reconstructor, m_cam_views);
-	Glut glut(scene3d);
+	// Decode + segment and carve on their own threads, unless asked otherwise or the
+	// thresholds are still to be determined (which changes them from the segmentation)
+	bool serial = false;
+	for (int a = 1; a < argc; ++a)
+		serial = serial || strcmp(argv[a], "--serial") == 0;
+	if (!serial && thresholds.empty())
+	{
+		cout << "Determining the thresholds, processing the frames serially" << endl;
+		serial = true;
+	}
+	FramePipeline pipeline(scene3d);
+	if (!serial) pipeline.start();
+
+	Glut glut(scene3d, serial ? NULL : &pipeline);
 
 #ifdef __linux__
 	glut.initializeLinux(SCENE_WINDOW.c_str(), argc, argv);
@@ -129,6 +368,73 @@ void VoxelReconstruction::run(int argc, char** argv)
 	glut.initializeWindows(SCENE_WINDOW.c_str());
 	glut.mainLoopWindows();
 #endif
+
+	return true;
+}
+
+/**
+ * Reconstruct the given frame range as fast as the hardware allows, without
+ * windows or timers: decode + segment and carve run on the pipeline's threads,
+ * the voxels are written on this one. Prints the throughput of every stage.
+ * Stops at the first frame that can't be written, and returns false then.
+ */
+bool VoxelReconstruction::runBatch(
+		Scene3DRenderer &scene3d, int first, int last, const string &output)
+{
+	VoxelWriter writer(output);
+	cout << "Reconstructing frames " << first << " to " << last << ", "
+			<< (writer.isDiscarding() ? "discarding the voxels" : "writing the voxels to " + output) << endl;
+
+	FramePipeline pipeline(scene3d, FramePipeline::DELIVER_FRAMES);
+	pipeline.start();
+	pipeline.seek(first);
+
+	bool written = true;
+	double segment_time = 0, carve_time = 0, write_time = 0;  // Busy time per stage (ms)
+	const int64 start = getTickCount();
+	for (int number = first; number <= last;)
+	{
+		FramePipeline::Frame* frame = pipeline.next();
+		if (frame == NULL)
+		{
+			this_thread::sleep_for(chrono::milliseconds(1));
+			continue;
+		}
+		assert(frame->number == number);
+		segment_time += frame->segment_time;
+		carve_time += frame->carve_time;
+
+		const int64 write_start = getTickCount();
+		if (!writer.write(frame->number, frame->visible_voxels))
+		{
+			cerr << "Unable to write the voxels of frame " << frame->number << " to: " << output << endl;
+			written = false;
+			break;
+		}
+		write_time += (getTickCount() - write_start) * 1000.0 / getTickFrequency();
+		++number;
+	}
+	const double total_time = (getTickCount() - start) * 1000.0 / getTickFrequency();
+	pipeline.stop();
+
+	const size_t frames = writer.getFramesWritten();
+	cout << "Reconstructed " << frames << " frames in " << total_time / 1000 << " s: "
+			<< (total_time > 0 ? 1000.0 * frames / total_time : 0) << " frames/s, "
+			<< (frames > 0 ? writer.getVoxelsWritten() / frames : 0) << " voxels/frame" << endl;
+	printStage("Decode + segment", segment_time, frames);
+	printStage("Carve (" + string(Reconstructor::getCarvingModeName(scene3d.getReconstructor().getCarvingMode())) + ")",
+			carve_time, frames);
+	printStage("Write", write_time, frames);
+	if (!writer.isDiscarding()) cout << "Wrote " << writer.getBytesWritten() / (1024.0 * 1024.0) << " MB" << endl;
+
+	for (size_t c = 0; c < m_cam_views.size(); ++c)
+	{
+		const FrameSource &source = m_cam_views[c]->getFrameSource();
+		cout << "Camera " << c + 1 << " read " << source.getFramesRead() << " frames from its " << source.getName()
+				<< " at " << source.getThroughput() << " frames/s" << endl;
+	}
+
+	return written;
 }
 
 } /* namespace nl_uu_science_gmt */
@@ -12,10 +12,13 @@
 #include <vector>
 
 #include "controllers/Camera.h"
+#include "controllers/Reconstructor.h"
 
 namespace nl_uu_science_gmt
 {
 
+class Scene3DRenderer;
+
 class VoxelReconstruction
 {
 	const std::string m_data_path;
@@ -23,13 +26,19 @@ class VoxelReconstruction
 
 	std::vector<Camera*> m_cam_views;
 
+	bool runBatch(
+			Scene3DRenderer &, int, int, const std::string &);
+
 public:
+	static const double DEFAULT_FRAME_CACHE;  // Default decoded frame cache size of all cameras (MB)
+
 	VoxelReconstruction(const std::string &, const int);
 	virtual ~VoxelReconstruction();
 
 	static void showKeys();
+	static bool parseVolumeArguments(int, char**, Reconstructor::Volume &);
 
-	void run(int, char**);
+	bool run(int, char**);
 };
 
 } /* namespace nl_uu_science_gmt */
@@ -23,6 +23,10 @@
 #include <sstream>
 
 #include "../utilities/General.h"
+#include "../utilities/ImageSequenceSource.h"
+#include "../utilities/RawFrameSource.h"
+#include "../utilities/SyntheticFrameSource.h"
+#include "../utilities/VideoFrameSource.h"
 
 using namespace std;
 using namespace cv;
@@ -32,6 +36,8 @@ namespace nl_uu_science_gmt
 
 vector<Point>* Camera::m_BoardCorners;  // marked checkerboard corners
 
+const double Camera::FRAME_RATE = 50;
+
 Camera::Camera(
 		const string &dp, const string &cp, const int id) :
 				m_data_path(dp),
@@ -40,15 +46,20 @@ Camera::Camera(
 {
 	m_initialized = false;
 
+	m_source = NULL;
+	m_source_type = SOURCE_AUTO;
+
 	m_fx = 0;
 	m_fy = 0;
 	m_cx = 0;
 	m_cy = 0;
 	m_frame_amount = 0;
+	m_frame_number = -1;
 }
 
 Camera::~Camera()
 {
+	delete m_source;
 }
 
 /**
@@ -75,28 +86,26 @@ bool Camera::initialize()
 	}
 	assert(!bg_image.empty());
 
-	// Disect the background image in HSV-color space
-	Mat bg_hsv_im;
-	cvtColor(bg_image, bg_hsv_im, CV_BGR2HSV);
-	split(bg_hsv_im, m_bg_hsv_channels);
-
-	// Open the video for this camera
-	m_video = VideoCapture(m_data_path + General::VideoFile);
-	assert(m_video.isOpened());
+	// Convert the background image to HSV-color space
+	cvtColor(bg_image, m_bg_hsv_image, CV_BGR2HSV);
 
-	// Assess the image size
-	m_plane_size.width = (int) m_video.get(CAP_PROP_FRAME_WIDTH);
-	m_plane_size.height = (int) m_video.get(CAP_PROP_FRAME_HEIGHT);
+	// Open the frames for this camera, the frame source determines the image size and the amount of frames
+	if (!openFrameSource(bg_image))
+	{
+		cout << "Unable to open the frames of camera " << m_id + 1 << endl;
+		return false;
+	}
+	m_plane_size = m_source->getSize();
 	assert(m_plane_size.area() > 0);
-
-	// Get the amount of video frames
-	m_video.set(CAP_PROP_POS_AVI_RATIO, 1);  // Go to the end of the video; 1 = 100%
-	m_frame_amount = (long) m_video.get(CAP_PROP_POS_FRAMES);
+	m_frame_amount = (long) m_source->getFrameAmount();
 	assert(m_frame_amount > 1);
-	m_video.set(CAP_PROP_POS_AVI_RATIO, 0);  // Go back to the start
+	m_frame_number = -1;
 
-	m_video.release(); //Re-open the file because _video.set(CV_CAP_PROP_POS_AVI_RATIO, 1) may screw it up
-	m_video = cv::VideoCapture(m_data_path + General::VideoFile);
+	// Allocate the per-frame buffers once, decoding and processing a frame reuses them
+	m_frame.create(m_plane_size, CV_8UC3);
+	m_foreground_image = Mat::zeros(m_plane_size, CV_8U);
+	m_mask_buffer.create(m_plane_size, CV_8U);
+	m_morphology_buffer.create(m_plane_size, CV_8U);
 
 	// Read the camera properties (XML)
 	FileStorage fs;
@@ -125,6 +134,24 @@ bool Camera::initialize()
 		m_fy = m_camera_matrix.at<float>(1, 1);
 		m_cx = m_camera_matrix.at<float>(0, 2);
 		m_cy = m_camera_matrix.at<float>(1, 2);
+
+		// Check the projection kernel against cv::projectPoints around the origin
+		if (m_projection.set(m_rotation_values, m_translation_values, m_camera_matrix, m_distortion_coeffs))
+		{
+			vector<Point3f> samples;
+			for (int x = -1000; x <= 1000; x += 500)
+				for (int y = -1000; y <= 1000; y += 500)
+					for (int z = 0; z <= 1500; z += 750)
+						samples.push_back(Point3f((float) x, (float) y, (float) z));
+
+			const double error = m_projection.compare(m_rotation_values, m_translation_values, m_camera_matrix,
+					m_distortion_coeffs, samples);
+			if (error > 0.05)
+			{
+				cerr << "Camera " << m_id + 1 << " projection kernel is off by " << error << "px, using cv::projectPoints" << endl;
+				m_projection = Projection();
+			}
+		}
 	}
 	else
 	{
@@ -143,18 +170,154 @@ bool Camera::initialize()
  */
 Mat& Camera::advanceVideoFrame()
 {
-	m_video >> m_frame;
-	assert(!m_frame.empty());
-	return m_frame;
+	return getVideoFrame(m_frame_number + 1);
+}
+
+/**
+ * Open the frame source of the chosen type. Automatically that's the
+ * pre-decoded frames if they're there and up to date, otherwise the video.
+ * A source that can't be opened falls back to the video as well.
+ */
+bool Camera::openFrameSource(
+		const Mat &bg_image)
+{
+	delete m_source;
+	m_source = NULL;
+
+	const string video_file = m_data_path + General::VideoFile;
+	if (m_source_type == SOURCE_AUTO || m_source_type == SOURCE_RAW)
+	{
+		RawFrameSource* raw = new RawFrameSource();
+		if (raw->open(m_data_path + General::RawFramesFile, video_file))
+			m_source = raw;
+		else
+			delete raw;
+	}
+	else if (m_source_type == SOURCE_IMAGES)
+	{
+		ImageSequenceSource* images = new ImageSequenceSource(FRAME_RATE);
+		if (images->open(m_data_path + General::ImageSequencePattern))
+			m_source = images;
+		else
+			delete images;
+	}
+	else if (m_source_type == SOURCE_SYNTHETIC)
+	{
+		m_source = new SyntheticFrameSource(bg_image, SyntheticFrameSource::DEFAULT_FRAMES, FRAME_RATE);
+	}
+
+	if (m_source == NULL)
+	{
+		if (m_source_type != SOURCE_AUTO && m_source_type != SOURCE_VIDEO)
+			cerr << "Camera " << m_id + 1 << " has no usable " << getSourceTypeName(m_source_type)
+					<< " frames, using the video" << endl;
+
+		VideoFrameSource* video = new VideoFrameSource();
+		if (!video->open(video_file, m_data_path + General::VideoIndexFile))
+		{
+			delete video;
+			return false;
+		}
+		m_source = video;
+	}
+
+	return true;
+}
+
+/**
+ * Decode the whole video once into a frame file next to it, unless that's done
+ * already, and play back from that file from now on (unless another source
+ * type was chosen)
+ */
+bool Camera::predecodeVideo()
+{
+	if (m_source->isZeroCopy()) return true;
+
+	const string raw_file = m_data_path + General::RawFramesFile;
+	if (!RawFrameFile::write(raw_file, m_data_path + General::VideoFile, m_frame_amount))
+	{
+		cerr << "Unable to write: " << raw_file << endl;
+		return false;
+	}
+	if (m_source_type != SOURCE_AUTO && m_source_type != SOURCE_RAW) return true;
+
+	RawFrameSource* raw = new RawFrameSource();
+	if (!raw->open(raw_file, m_data_path + General::VideoFile) || raw->getSize() != m_plane_size)
+	{
+		delete raw;
+		return false;
+	}
+	delete m_source;
+	m_source = raw;
+	m_frame_amount = (long) m_source->getFrameAmount();
+
+	return true;
+}
+
+/**
+ * Read the video frame with the given number into the given image: copy it
+ * from the frame cache if it's there, otherwise read it from the frame source.
+ * Zero-copy sources point the image at their own (read-only) frame, the
+ * others reuse the image's buffer. If the source can't read the frame the
+ * image keeps its previous frame (black if it had none) and false is returned.
+ */
+bool Camera::readVideoFrame(
+		int frame_number, Mat &frame)
+{
+	if (m_frame_cache.get(frame_number, frame)) return true;
+
+	if (!m_source->read(frame_number, frame))
+	{
+		cerr << "Camera " << m_id + 1 << " can't read frame " << frame_number << " from its " << m_source->getName() << endl;
+		if (frame.empty()) frame = Mat::zeros(m_plane_size, CV_8UC3);
+		return false;
+	}
+
+	m_frame_cache.put(frame_number, frame);
+	return true;
 }
 
 /**
- * Set the video location to the given frame number
+ * Set the video location to the given frame number, the video reader only seeks
+ * when that frame isn't cached. The seek itself happens when the frame is read,
+ * where the cameras run in parallel.
  */
 void Camera::setVideoFrame(
 		int frame_number)
 {
-	m_video.set(CAP_PROP_POS_FRAMES, frame_number);
+	m_frame_number = frame_number - 1;
+}
+
+/**
+ * Cache as many decoded frames as fit in the given amount of bytes, none when
+ * the frame source hands out its frames without copying
+ */
+void Camera::setFrameCacheBudget(
+		size_t bytes)
+{
+	if (m_source->isZeroCopy()) bytes = 0;
+	m_frame_cache.setCapacity(bytes / ((size_t) m_plane_size.area() * 3), m_plane_size, CV_8UC3);
+}
+
+/**
+ * Name of a frame source type, as on the command line
+ */
+const char* Camera::getSourceTypeName(
+		FrameSourceType type)
+{
+	switch (type)
+	{
+	case SOURCE_VIDEO:
+		return "video";
+	case SOURCE_IMAGES:
+		return "images";
+	case SOURCE_RAW:
+		return "raw";
+	case SOURCE_SYNTHETIC:
+		return "synthetic";
+	default:
+		return "auto";
+	}
 }
 
 /**
@@ -163,8 +326,9 @@ void Camera::setVideoFrame(
 Mat& Camera::getVideoFrame(
 		int frame_number)
 {
-	setVideoFrame(frame_number);
-	return advanceVideoFrame();
+	readVideoFrame(frame_number, m_frame);
+	m_frame_number = frame_number;
+	return m_frame;
 }
 
 /**
@@ -522,12 +686,38 @@ cv::Point Camera::projectOnView(
 	return image_points.front();
 }
 
+/**
+ * Projects a batch of points from the scene space to the image coordinates
+ * in one call, into a caller provided buffer of the same amount of points.
+ * Uses the vectorized projection kernel, or cv::projectPoints for camera
+ * models the kernel doesn't support.
+ */
+void Camera::projectOnView(
+		const Point3f* object_points, Point2f* image_points, size_t amount) const
+{
+	if (amount == 0) return;
+
+	if (m_projection.isValid())
+	{
+		m_projection.project(object_points, image_points, amount);
+		return;
+	}
+
+	const Mat objects((int) amount, 1, CV_32FC3, (void*) object_points);
+	Mat images((int) amount, 1, CV_32FC2, (void*) image_points);
+	projectPoints(objects, m_rotation_values, m_translation_values, m_camera_matrix, m_distortion_coeffs, images);
+
+	// projectPoints must have written into the given buffer instead of reallocating
+	assert(images.data == (uchar* ) image_points);
+}
+
 /**
  * Non-static for backwards compatibility
  */
 Point Camera::projectOnView(
 		const Point3f &coords)
 {
+	if (m_projection.isValid()) return m_projection.project(coords);
 	return projectOnView(coords, m_rotation_values, m_translation_values, m_camera_matrix, m_distortion_coeffs);
 }
 
@@ -14,6 +14,10 @@
 #include <string>
 #include <vector>
 
+#include "../utilities/FrameCache.h"
+#include "../utilities/FrameSource.h"
+#include "../utilities/Projection.h"
+
 namespace nl_uu_science_gmt
 {
 
@@ -21,6 +25,23 @@ namespace nl_uu_science_gmt
 
 class Camera
 {
+public:
+	/*
+	 * Where the frames come from, selectable on the command line
+	 */
+	enum FrameSourceType
+	{
+		SOURCE_AUTO,                            // Pre-decoded frames if up to date, otherwise the video
+		SOURCE_VIDEO,                           // Decode the video
+		SOURCE_IMAGES,                          // Numbered image files
+		SOURCE_RAW,                             // Pre-decoded frames
+		SOURCE_SYNTHETIC,                       // Generated frames, no file I/O or decoding
+		SOURCE_TYPES                            // Amount of frame source types
+	};
+
+	static const double FRAME_RATE;             // Frame rate of image sequences and synthetic frames
+
+private:
 	static std::vector<cv::Point>* m_BoardCorners;  // marked checkerboard corners
 
 	bool m_initialized;                             // Is this camera successfully initialized
@@ -29,10 +50,14 @@ class Camera
 	const std::string m_cam_props_file;             // Camera properties filename
 	const int m_id;                                 // Camera ID
 
-	std::vector<cv::Mat> m_bg_hsv_channels;          // Background HSV channel images
+	cv::Mat m_bg_hsv_image;                          // Background image in HSV color space (interleaved)
 	cv::Mat m_foreground_image;                      // This camera's foreground image (binary)
+	cv::Mat m_mask_buffer;                           // Per-frame scratch: background subtraction mask
+	cv::Mat m_morphology_buffer;                     // Per-frame scratch: eroded mask
 
-	cv::VideoCapture m_video;                        // Video reader
+	FrameSourceType m_source_type;                   // Requested frame source
+	FrameSource* m_source;                           // Frame source (owned)
+	FrameCache m_frame_cache;                        // Recently decoded frames
 
 	cv::Size m_plane_size;                           // Camera's FoV size
 	long m_frame_amount;                             // Amount of frames in this camera's video
@@ -44,6 +69,8 @@ class Camera
 
 	float m_fx, m_fy, m_cx, m_cy;                   // Focal lenghth (fx, fy), camera center (cx, cy)
 
+	Projection m_projection;                         // Vectorized projection with this camera's model
+
 	cv::Mat m_rt;                                    // R matrix
 	cv::Mat m_inverse_rt;                            // R's inverse matrix
 
@@ -52,6 +79,9 @@ class Camera
 	std::vector<cv::Point3f> m_camera_floor;         // Projection of the camera itself onto the ground floor view
 
 	cv::Mat m_frame;                                 // Current video frame (image)
+	int m_frame_number;                              // Frame number of m_frame
+
+	bool openFrameSource(const cv::Mat &);
 
 	static void onMouse(int, int, int, int, void*);
 	void initCamLoc();
@@ -67,13 +97,17 @@ public:
 	bool initialize();
 
 	cv::Mat& advanceVideoFrame();
+	bool readVideoFrame(int, cv::Mat &);
 	cv::Mat& getVideoFrame(int);
 	void setVideoFrame(int);
+	void setFrameCacheBudget(size_t);
+	bool predecodeVideo();
 
 	static bool detExtrinsics(const std::string &, const std::string &, const std::string &, const std::string &);
 
 	static cv::Point projectOnView(const cv::Point3f &, const cv::Mat &, const cv::Mat &, const cv::Mat &, const cv::Mat &);
 	cv::Point projectOnView(const cv::Point3f &);
+	void projectOnView(const cv::Point3f*, cv::Point2f*, size_t) const;
 
 	const std::string& getCamPropertiesFile() const
 	{
@@ -90,14 +124,24 @@ public:
 		return m_id;
 	}
 
-	const cv::VideoCapture& getVideo() const
+	static const char* getSourceTypeName(FrameSourceType);
+
+	FrameSourceType getFrameSourceType() const
+	{
+		return m_source_type;
+	}
+
+	/*
+	 * Choose the frame source before initializing the camera
+	 */
+	void setFrameSourceType(FrameSourceType type)
 	{
-		return m_video;
+		m_source_type = type;
 	}
 
-	void setVideo(const cv::VideoCapture& video)
+	const FrameSource& getFrameSource() const
 	{
-		m_video = video;
+		return *m_source;
 	}
 
 	long getFramesAmount() const
@@ -105,9 +149,14 @@ public:
 		return m_frame_amount;
 	}
 
-	const std::vector<cv::Mat>& getBgHsvChannels() const
+	const FrameCache& getFrameCache() const
 	{
-		return m_bg_hsv_channels;
+		return m_frame_cache;
+	}
+
+	const cv::Mat& getBgHsvImage() const
+	{
+		return m_bg_hsv_image;
 	}
 
 	bool isInitialized() const
@@ -130,6 +179,24 @@ public:
 		m_foreground_image = foregroundImage;
 	}
 
+	/*
+	 * Persistent per-frame buffers, allocated once at the camera's FoV size
+	 */
+	cv::Mat& getForegroundBuffer()
+	{
+		return m_foreground_image;
+	}
+
+	cv::Mat& getMaskBuffer()
+	{
+		return m_mask_buffer;
+	}
+
+	cv::Mat& getMorphologyBuffer()
+	{
+		return m_morphology_buffer;
+	}
+
 	const cv::Mat& getFrame() const
 	{
 		return m_frame;
@@ -149,6 +216,31 @@ public:
 	{
 		return m_camera_plane;
 	}
+
+	bool hasProjectionKernel() const
+	{
+		return m_projection.isValid();
+	}
+
+	const cv::Mat& getCameraMatrix() const
+	{
+		return m_camera_matrix;
+	}
+
+	const cv::Mat& getDistortionCoeffs() const
+	{
+		return m_distortion_coeffs;
+	}
+
+	const cv::Mat& getRotationValues() const
+	{
+		return m_rotation_values;
+	}
+
+	const cv::Mat& getTranslationValues() const
+	{
+		return m_translation_values;
+	}
 };
 
 } /* namespace nl_uu_science_gmt */
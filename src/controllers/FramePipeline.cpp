@@ -0,0 +1,370 @@
+/*
+ * FramePipeline.cpp
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#include "FramePipeline.h"
+
+#include <cassert>
+#include <chrono>
+
+#include "Camera.h"
+#include "../utilities/AllocationCounter.h"
+
+using namespace std;
+using namespace cv;
+
+namespace nl_uu_science_gmt
+{
+
+namespace
+{
+
+/*
+ * Wait a moment for another stage
+ */
+void backoff()
+{
+	this_thread::sleep_for(chrono::milliseconds(1));
+}
+
+} /* namespace */
+
+const size_t FramePipeline::FRAMES;
+const int FramePipeline::SNAPSHOTS;
+const int FramePipeline::SNAPSHOT_NEW;
+
+/**
+ * Allocate every frame's and snapshot's buffers once, all frames start out free
+ */
+FramePipeline::FramePipeline(
+		Scene3DRenderer &scene3d, Delivery delivery) :
+				m_scene3d(scene3d),
+				m_delivery(delivery),
+				m_frames(FRAMES),
+				m_free(FRAMES),
+				m_segmented(FRAMES),
+				m_carved(FRAMES),
+				m_shown(NULL),
+				m_snapshot_back(0),
+				m_snapshot_ready(1),
+				m_snapshot_front(2),
+				m_published(0),
+				m_generation(0),
+				m_seek_frame(0),
+				m_carving_request(-1),
+				m_preview_camera(-1),
+				m_h_threshold(scene3d.getHThreshold()),
+				m_s_threshold(scene3d.getSThreshold()),
+				m_v_threshold(scene3d.getVThreshold()),
+				m_paused(false),
+				m_changes(0),
+				m_carving_mode(scene3d.getReconstructor().getCarvingMode()),
+				m_running(false)
+{
+	const vector<Camera*> &cameras = m_scene3d.getCameras();
+	for (size_t f = 0; f < FRAMES; ++f)
+	{
+		Frame &frame = m_frames[f];
+		frame.number = -1;
+		frame.generation = 0;
+		frame.segment_time = 0;
+		frame.carve_time = 0;
+		frame.preview_camera = -1;
+
+		for (size_t c = 0; c < cameras.size(); ++c)
+		{
+			const Size size = cameras[c]->getSize();
+			frame.images.push_back(Mat(size, CV_8UC3));
+			frame.masks.push_back(Mat(size, CV_8U));
+			frame.morphologies.push_back(Mat(size, CV_8U));
+			frame.foregrounds.push_back(Mat::zeros(size, CV_8U));
+			frame.foreground_data.push_back(frame.foregrounds.back().ptr());
+		}
+		frame.visible_voxels.reserve(m_scene3d.getReconstructor().getVoxels().size());
+		if (!cameras.empty())
+		{
+			const Size size = cameras.front()->getSize();
+			frame.preview.create(size.height, size.width * 2, CV_8UC3);
+		}
+
+		m_free.push(&frame);
+	}
+
+	for (int s = 0; s < SNAPSHOTS; ++s)
+	{
+		Snapshot &snapshot = m_snapshots[s];
+		snapshot.number = -1;
+		snapshot.generation = 0;
+		snapshot.version = 0;
+		snapshot.carve_time = 0;
+		snapshot.preview_camera = -1;
+		snapshot.visible_voxels.reserve(m_scene3d.getReconstructor().getVoxels().size());
+		if (!cameras.empty()) snapshot.preview.create(m_frames.front().preview.size(), CV_8UC3);
+	}
+}
+
+FramePipeline::~FramePipeline()
+{
+	stop();
+}
+
+/**
+ * Start the decode and carve stages, they idle until the first seek. The
+ * calling thread only takes the finished frames, so its allocations no longer
+ * count towards the stages' allocation checks. The thresholds must be set.
+ */
+void FramePipeline::start()
+{
+	assert(!m_scene3d.getUpdateH() && !m_scene3d.getUpdateS() && !m_scene3d.getUpdateV());
+	if (m_running.exchange(true)) return;
+#ifdef DEBUG
+	AllocationCounter::excludeThread();
+#endif
+	m_decoder = thread(&FramePipeline::decode, this);
+	m_carver = thread(&FramePipeline::carve, this);
+}
+
+/**
+ * Stop the stages and wait for them to finish their current frame
+ */
+void FramePipeline::stop()
+{
+	m_running = false;
+	if (m_decoder.joinable()) m_decoder.join();
+	if (m_carver.joinable()) m_carver.join();
+}
+
+/**
+ * Continue from the given frame number, frames already in flight are dropped
+ * (render thread)
+ */
+void FramePipeline::seek(
+		int frame_number)
+{
+	m_seek_frame = frame_number;
+	++m_generation;
+	++m_changes;
+}
+
+/**
+ * Switch the carving engine before the next frame is carved, and compare all
+ * engines on that frame (render thread)
+ */
+void FramePipeline::setCarvingMode(
+		Reconstructor::CarvingMode mode)
+{
+	m_carving_mode = mode;
+	m_carving_request = mode;
+}
+
+/**
+ * The next carved frame of the current generation, NULL if none is ready yet.
+ * The frame stays valid until the next frame is returned, the previous one
+ * goes back to the decode stage (render thread, DELIVER_FRAMES).
+ */
+FramePipeline::Frame* FramePipeline::next()
+{
+	const unsigned int generation = m_generation;
+
+	Frame* frame;
+	while (m_carved.pop(frame))
+	{
+		if (frame->generation == generation)
+		{
+			if (m_shown != NULL) m_free.push(m_shown);
+			m_shown = frame;
+			return frame;
+		}
+		m_free.push(frame);  // Decoded before the last seek
+	}
+
+	return NULL;
+}
+
+/**
+ * The newest published snapshot, NULL before the first. It stays valid and
+ * unchanged until the next call (render thread, DELIVER_SNAPSHOTS).
+ */
+const FramePipeline::Snapshot* FramePipeline::getSnapshot()
+{
+	if ((m_snapshot_ready & SNAPSHOT_NEW) != 0) m_snapshot_front = m_snapshot_ready.exchange(m_snapshot_front) & ~SNAPSHOT_NEW;
+
+	const Snapshot &snapshot = m_snapshots[m_snapshot_front];
+	return snapshot.version > 0 ? &snapshot : NULL;
+}
+
+/**
+ * Check if the frame taken last predates the last seek (render thread)
+ */
+bool FramePipeline::isSeeking() const
+{
+	if (m_delivery == DELIVER_FRAMES) return m_shown == NULL || m_shown->generation != m_generation;
+
+	const Snapshot &snapshot = m_snapshots[m_snapshot_front];
+	return snapshot.version == 0 || snapshot.generation != m_generation;
+}
+
+/**
+ * Check if the stages run without a carving mode switch, then processing a
+ * frame only uses the frames' persistent buffers
+ */
+bool FramePipeline::isSteady() const
+{
+	return m_carving_request < 0;
+}
+
+/**
+ * Decode + segment stage: read the next frame of every camera into a free
+ * frame and separate its foreground, the cameras in parallel, then compose
+ * the preview of the previewed camera. Wraps to the start at the end of the
+ * video.
+ */
+void FramePipeline::decode()
+{
+	const vector<Camera*> &cameras = m_scene3d.getCameras();
+	const int last = (int) m_scene3d.getNumberOfFrames() - 2;
+
+	unsigned int generation = 0;
+	int number = 0;
+	while (m_running)
+	{
+		Frame* frame;
+		const unsigned int requested = m_generation;
+		if (requested == 0 || (m_paused && requested == generation) || !m_free.pop(frame))
+		{
+			backoff();
+			continue;
+		}
+
+#ifdef DEBUG
+		const size_t allocations = AllocationCounter::getCount();
+		const unsigned int changes = m_changes;
+		const bool steady = requested == generation && isSteady();
+#endif
+		if (requested != generation)
+		{
+			generation = requested;
+			number = m_seek_frame;
+		}
+		else if (++number > last)
+		{
+			number = 0;
+		}
+		frame->number = number;
+		frame->generation = generation;
+
+		const Scene3DRenderer::Thresholds thresholds = { m_h_threshold, m_s_threshold, m_v_threshold };
+		const int64 start = getTickCount();
+
+		int c;
+#pragma omp parallel for schedule(dynamic) private(c)
+		for (c = 0; c < (int) cameras.size(); ++c)
+		{
+			cameras[c]->readVideoFrame(number, frame->images[c]);
+			m_scene3d.processForeground(cameras[c], c, thresholds, frame->images[c], frame->masks[c],
+					frame->morphologies[c], frame->foregrounds[c]);
+			frame->foreground_data[c] = frame->foregrounds[c].ptr();
+		}
+		frame->segment_time = (getTickCount() - start) * 1000.0 / getTickFrequency();
+
+		// Compose the video window preview off the render thread
+		const int preview = m_preview_camera;
+		frame->preview_camera = preview >= 0 && preview < (int) cameras.size() ? preview : -1;
+		if (frame->preview_camera >= 0)
+			Scene3DRenderer::createPreview(frame->images[preview], frame->foregrounds[preview], frame->preview);
+#ifdef DEBUG
+		// Nothing (in this or the carve stage) may have allocated for a frame of a steady run
+		if (steady && m_changes == changes && isSteady()) assert(AllocationCounter::getCount() == allocations);
+#endif
+
+		// Every queue holds all frames, so this never waits
+		while (!m_segmented.push(frame))
+			backoff();
+	}
+}
+
+/**
+ * Carve stage: carve the voxel space of every segmented frame, skipping frames
+ * that predate the last seek. Carving mode switches apply between frames.
+ * Publishes the frames as snapshots, or hands them on in order.
+ */
+void FramePipeline::carve()
+{
+	Reconstructor &reconstructor = m_scene3d.getReconstructor();
+
+	unsigned int generation = 0;
+	while (m_running)
+	{
+		Frame* frame;
+		if (!m_segmented.pop(frame))
+		{
+			backoff();
+			continue;
+		}
+
+		if (frame->generation == m_generation)
+		{
+#ifdef DEBUG
+			const size_t allocations = AllocationCounter::getCount();
+			const unsigned int changes = m_changes;
+			const bool steady = frame->generation == generation && isSteady();
+#endif
+			int mode = m_carving_request;  // Cleared after the switch, so the decode stage sees it
+			if (mode >= 0)
+			{
+				++m_changes;
+				reconstructor.setCarvingMode((Reconstructor::CarvingMode) mode);
+				reconstructor.compareCarving(frame->foreground_data);
+				m_carving_request.compare_exchange_strong(mode, -1);
+				++m_changes;
+			}
+
+			frame->carve_time = reconstructor.update(frame->foreground_data, frame->visible_voxels);
+			generation = frame->generation;
+#ifdef DEBUG
+			// Nothing (in this or the decode stage) may have allocated for a frame of a steady run
+			if (steady && m_changes == changes && isSteady()) assert(AllocationCounter::getCount() == allocations);
+#endif
+		}
+
+		if (m_delivery == DELIVER_SNAPSHOTS)
+		{
+			if (frame->generation == m_generation) publish(*frame);
+			while (!m_free.push(frame))
+				backoff();
+		}
+		else
+		{
+			while (!m_carved.push(frame))
+				backoff();
+		}
+	}
+}
+
+/**
+ * Swap the results of a frame into the snapshot to publish, and publish it.
+ * Waits for the render thread to take the snapshot published before, unless
+ * the frame predates a seek meanwhile (carve thread).
+ */
+void FramePipeline::publish(
+		Frame &frame)
+{
+	while ((m_snapshot_ready & SNAPSHOT_NEW) != 0 && frame.generation == m_generation && m_running)
+		backoff();
+	if (frame.generation != m_generation || !m_running) return;
+
+	Snapshot &snapshot = m_snapshots[m_snapshot_back];
+	snapshot.number = frame.number;
+	snapshot.generation = frame.generation;
+	snapshot.version = ++m_published;
+	snapshot.visible_voxels.swap(frame.visible_voxels);
+	snapshot.carve_time = frame.carve_time;
+	cv::swap(snapshot.preview, frame.preview);
+	snapshot.preview_camera = frame.preview_camera;
+
+	m_snapshot_back = m_snapshot_ready.exchange(m_snapshot_back | SNAPSHOT_NEW) & ~SNAPSHOT_NEW;
+}
+
+} /* namespace nl_uu_science_gmt */
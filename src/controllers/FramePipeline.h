@@ -0,0 +1,173 @@
+/*
+ * FramePipeline.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#ifndef FRAMEPIPELINE_H_
+#define FRAMEPIPELINE_H_
+
+#include <opencv2/core/core.hpp>
+#include <atomic>
+#include <stddef.h>
+#include <thread>
+#include <vector>
+
+#include "Reconstructor.h"
+#include "Scene3DRenderer.h"
+#include "../utilities/SpscQueue.h"
+
+namespace nl_uu_science_gmt
+{
+
+/*
+ * Staged frame processing: decode + segment -> carve -> render
+ * The decode and carve stages run on their own threads and hand frames on
+ * through bounded lock-free SPSC queues, so frame N+1 is decoded while frame N
+ * is carved. A fixed set of frames circulates, the decode stage waits for a
+ * free one (backpressure). A seek starts a new generation, frames of older
+ * generations are dropped.
+ * Interactively the carve stage publishes every finished frame as an immutable
+ * snapshot (voxels, video window preview, frame number) through a lock-free
+ * triple buffer and recycles the frame. The render thread draws the newest
+ * snapshot without waiting on the stages, so a slow carve never blocks it. A
+ * snapshot isn't replaced before the render thread took it, so playback runs
+ * at most at the display rate. In batch mode the render thread takes every
+ * frame in order instead.
+ * The thresholds are handed over from the render thread, determining them
+ * only runs serially.
+ */
+class FramePipeline
+{
+public:
+	/*
+	 * How the finished frames reach the render thread
+	 */
+	enum Delivery
+	{
+		DELIVER_SNAPSHOTS,  // The newest snapshot, see getSnapshot()
+		DELIVER_FRAMES      // Every frame in order, see next()
+	};
+
+	/*
+	 * One frame travelling through the stages
+	 */
+	struct Frame
+	{
+		int number;                                          // Video frame number
+		unsigned int generation;                             // Seek generation the frame was decoded in
+		std::vector<cv::Mat> images;                         // Video frame per camera
+		std::vector<cv::Mat> masks;                          // Segmentation scratch per camera
+		std::vector<cv::Mat> morphologies;                   // Segmentation scratch per camera
+		std::vector<cv::Mat> foregrounds;                    // Foreground image per camera
+		std::vector<const uchar*> foreground_data;           // Foreground image data per camera
+		double segment_time;                                 // Decode + segment duration (ms)
+		std::vector<Reconstructor::Voxel> visible_voxels;    // Carving result
+		double carve_time;                                   // Carving duration (ms)
+		cv::Mat preview;                                     // Video frame and foreground image side by side
+		int preview_camera;                                  // Camera of the preview, -1 if none
+	};
+
+	/*
+	 * Reconstruction of a finished frame, immutable once published
+	 */
+	struct Snapshot
+	{
+		int number;                                          // Video frame number
+		unsigned int generation;                             // Seek generation the frame was decoded in
+		size_t version;                                      // Publication number, 0 if never published
+		std::vector<Reconstructor::Voxel> visible_voxels;    // Carving result
+		double carve_time;                                   // Carving duration (ms)
+		cv::Mat preview;                                     // Video frame and foreground image side by side
+		int preview_camera;                                  // Camera of the preview, -1 if none
+	};
+
+private:
+	// Frames in flight: one per stage plus one queued between each pair of stages
+	static const size_t FRAMES = 4;
+	// Snapshots of the triple buffer: published, being written and being drawn
+	static const int SNAPSHOTS = 3;
+	// Flag of m_snapshot_ready: published after the render thread took the last one
+	static const int SNAPSHOT_NEW = 4;
+
+	Scene3DRenderer &m_scene3d;
+	const Delivery m_delivery;
+
+	std::vector<Frame> m_frames;                 // All frames
+	SpscQueue<Frame*> m_free;                    // Carve or render -> decode: frames to reuse
+	SpscQueue<Frame*> m_segmented;               // Decode -> carve
+	SpscQueue<Frame*> m_carved;                  // Carve -> render (DELIVER_FRAMES)
+	Frame* m_shown;                              // Frame taken last (render thread, DELIVER_FRAMES)
+
+	Snapshot m_snapshots[SNAPSHOTS];             // Triple buffer (DELIVER_SNAPSHOTS)
+	int m_snapshot_back;                         // Snapshot to publish next (carve thread)
+	std::atomic<int> m_snapshot_ready;           // Snapshot published last, with SNAPSHOT_NEW until taken
+	int m_snapshot_front;                        // Snapshot taken last (render thread)
+	size_t m_published;                          // Snapshots published (carve thread)
+
+	std::atomic<unsigned int> m_generation;      // Incremented on every seek, 0 until the first
+	std::atomic<int> m_seek_frame;               // Frame to continue from after the last seek
+	std::atomic<int> m_carving_request;          // Carving mode to switch to, -1 if none
+	std::atomic<int> m_preview_camera;           // Camera to compose the previews of, -1 for none
+	std::atomic<int> m_h_threshold;              // Hue threshold for the next frames
+	std::atomic<int> m_s_threshold;              // Saturation threshold for the next frames
+	std::atomic<int> m_v_threshold;              // Value threshold for the next frames
+	std::atomic<bool> m_paused;                  // Decode only the frames asked for by seeks
+	std::atomic<unsigned int> m_changes;         // Seeks and carving mode switches, for the allocation checks
+	Reconstructor::CarvingMode m_carving_mode;   // Carving mode as requested (render thread)
+
+	std::atomic<bool> m_running;                 // Stages keep running
+	std::thread m_decoder;                       // Decode + segment stage
+	std::thread m_carver;                        // Carve stage
+
+	void decode();
+	void carve();
+	void publish(
+			Frame &);
+	bool isSteady() const;
+
+public:
+	FramePipeline(
+			Scene3DRenderer &, Delivery = DELIVER_SNAPSHOTS);
+	virtual ~FramePipeline();
+
+	void start();
+	void stop();
+
+	void seek(
+			int);
+	void setCarvingMode(
+			Reconstructor::CarvingMode);
+	Frame* next();
+	const Snapshot* getSnapshot();
+	bool isSeeking() const;
+
+	void setPaused(
+			bool paused)
+	{
+		m_paused = paused;
+	}
+
+	void setThresholds(
+			const Scene3DRenderer::Thresholds &thresholds)
+	{
+		m_h_threshold = thresholds.h;
+		m_s_threshold = thresholds.s;
+		m_v_threshold = thresholds.v;
+	}
+
+	void setPreviewCamera(
+			int camera)
+	{
+		m_preview_camera = camera;
+	}
+
+	Reconstructor::CarvingMode getCarvingMode() const
+	{
+		return m_carving_mode;
+	}
+};
+
+} /* namespace nl_uu_science_gmt */
+
+#endif /* FRAMEPIPELINE_H_ */
@@ -17,6 +17,7 @@
 #include <opencv2/imgproc/imgproc.hpp>
 #include <opencv2/imgproc/types_c.h>
 #include <stddef.h>
+#include <cassert>
 #include <cmath>
 #include <complex>
 #include <cstdlib>
@@ -26,9 +27,11 @@
 #include <valarray>
 #include <vector>
 
+#include "../utilities/AllocationCounter.h"
 #include "../utilities/General.h"
 #include "arcball.h"
 #include "Camera.h"
+#include "FramePipeline.h"
 #include "Reconstructor.h"
 #include "Scene3DRenderer.h"
 
@@ -41,8 +44,10 @@ namespace nl_uu_science_gmt
 Glut* Glut::m_Glut;
 
 Glut::Glut(
-		Scene3DRenderer &s3d) :
-				m_scene3d(s3d)
+		Scene3DRenderer &s3d, FramePipeline* pipeline) :
+				m_scene3d(s3d),
+				m_pipeline(pipeline),
+				m_scene_lists(0)
 {
 	// static pointer to this class so we can get to it from the static GL events
 	m_Glut = this;
@@ -256,6 +261,16 @@ void Glut::reset()
 void Glut::quit()
 {
 	m_Glut->getScene3d().setQuit(true);
+	if (m_Glut->m_pipeline != NULL) m_Glut->m_pipeline->stop();
+
+	// Frame source throughput, to compare the sources on this sequence
+	const vector<Camera*> &cameras = m_Glut->getScene3d().getCameras();
+	for (size_t c = 0; c < cameras.size(); ++c)
+	{
+		const FrameSource &source = cameras[c]->getFrameSource();
+		cout << "Camera " << c + 1 << " read " << source.getFramesRead() << " frames from its " << source.getName()
+				<< " at " << source.getThroughput() << " frames/s" << endl;
+	}
 	exit(EXIT_SUCCESS);
 }
 
@@ -306,6 +321,14 @@ void Glut::keyboard(
 			bool volume = scene3d.isShowVolume();
 			scene3d.setShowVolume(!volume);
 		}
+		else if (key == 'x' || key == 'X')
+		{
+#ifdef _WIN32
+			cerr << "ShowCubes() not supported on Windows!" << endl;
+#endif
+			bool cubes = scene3d.isShowCubes();
+			scene3d.setShowCubes(!cubes);
+		}
 		else if (key == 'g' || key == 'G')
 		{
 			bool floor = scene3d.isShowGrdFlr();
@@ -335,6 +358,30 @@ void Glut::keyboard(
 			reset();
 			arcball_reset();
 		}
+		else if (key == 'm' || key == 'M')
+		{
+			Reconstructor &reconstructor = scene3d.getReconstructor();
+			FramePipeline* pipeline = m_Glut->m_pipeline;
+			if (pipeline != NULL)
+			{
+				// The carve stage switches and compares, on the current frame again
+				const int mode = (pipeline->getCarvingMode() + 1) % Reconstructor::CARVING_MODES;
+				pipeline->setCarvingMode((Reconstructor::CarvingMode) mode);
+				pipeline->seek(scene3d.getCurrentFrame());
+				cout << "Carving mode: " << Reconstructor::getCarvingModeName(pipeline->getCarvingMode()) << endl;
+			}
+			else
+			{
+				const int mode = (reconstructor.getCarvingMode() + 1) % Reconstructor::CARVING_MODES;
+				reconstructor.setCarvingMode((Reconstructor::CarvingMode) mode);
+				cout << "Carving mode: " << Reconstructor::getCarvingModeName(reconstructor.getCarvingMode()) << endl;
+				if (scene3d.getPreviousFrame() >= 0)
+				{
+					reconstructor.compareCarving();
+					reconstructor.update();
+				}
+			}
+		}
 	}
 	else if (key_i > 0 && key_i <= (int) scene3d.getCameras().size())
 	{
@@ -512,6 +559,10 @@ void Glut::reshape(
 	m_Glut->getScene3d().setSize(width, height, ar);
 	glViewport(0, 0, width, height);
 	reset();
+
+	// Rebuild the static scene on the next redraw
+	if (m_Glut->m_scene_lists != 0) glDeleteLists(m_Glut->m_scene_lists, SCENE_LISTS);
+	m_Glut->m_scene_lists = 0;
 }
 
 /**
@@ -543,22 +594,24 @@ void Glut::display()
 
 	arcball_rotate();
 
+	if (m_Glut->m_scene_lists == 0) buildSceneLists();
+
 	Scene3DRenderer& scene3d = m_Glut->getScene3d();
 	if (scene3d.isShowGrdFlr())
-		drawGrdGrid();
+		drawSceneList(LIST_FLOOR);
 	if (scene3d.isShowCam())
-		drawCamCoord();
+		drawSceneList(LIST_CAMERAS);
 	if (scene3d.isShowVolume())
-		drawVolume();
+		drawSceneList(LIST_VOLUME);
 	if (scene3d.isShowArcball())
 		drawArcball();
 
 	drawVoxels();
 
 	if (scene3d.isShowOrg())
-		drawWCoord();
+		drawSceneList(LIST_ORIGIN);
 	if (scene3d.isShowInfo())
-		drawInfo();
+		drawSceneList(LIST_INFO);
 
 	glFlush();
 
@@ -592,26 +645,76 @@ void Glut::update(
 		// Quit signaled
 		quit();
 	}
+	FramePipeline* pipeline = m_Glut->m_pipeline;
 	if (scene3d.getCurrentFrame() > scene3d.getNumberOfFrames() - 2)
 	{
 		// Go to the start of the video if we've moved beyond the end
 		scene3d.setCurrentFrame(0);
-		for (size_t c = 0; c < scene3d.getCameras().size(); ++c)
+		for (size_t c = 0; pipeline == NULL && c < scene3d.getCameras().size(); ++c)
 			scene3d.getCameras()[c]->setVideoFrame(scene3d.getCurrentFrame());
 	}
 	if (scene3d.getCurrentFrame() < 0)
 	{
 		// Go to the end of the video if we've moved before the start
 		scene3d.setCurrentFrame(scene3d.getNumberOfFrames() - 2);
-		for (size_t c = 0; c < scene3d.getCameras().size(); ++c)
+		for (size_t c = 0; pipeline == NULL && c < scene3d.getCameras().size(); ++c)
 			scene3d.getCameras()[c]->setVideoFrame(scene3d.getCurrentFrame());
 	}
-	if (!scene3d.isPaused())
+	if (!scene3d.isPaused() && pipeline == NULL)
 	{
 		// If not paused move to the next frame
 		scene3d.setCurrentFrame(scene3d.getCurrentFrame() + 1);
 	}
-	if (scene3d.getCurrentFrame() != scene3d.getPreviousFrame())
+#ifdef DEBUG
+	// Once the first frame is processed (and the thresholds are set), processing
+	// and showing a frame only uses persistent buffers. The pipeline's stages
+	// check their own frames.
+	const size_t allocations = AllocationCounter::getCount();
+	const bool steady = pipeline == NULL && scene3d.getPreviousFrame() >= 0 && !scene3d.getUpdateH()
+			&& !scene3d.getUpdateS() && !scene3d.getUpdateV();
+#endif
+
+	const int preview_camera = scene3d.getCurrentCamera() != -1 ? scene3d.getCurrentCamera() : scene3d.getPreviousCamera();
+	const FramePipeline::Snapshot* snapshot = pipeline != NULL ? pipeline->getSnapshot() : NULL;
+
+	if (pipeline != NULL)
+	{
+		// Only hand over requests, the stages process the frames and publish snapshots
+		pipeline->setPaused(scene3d.isPaused());
+		pipeline->setPreviewCamera(preview_camera);
+		pipeline->setThresholds(scene3d.getThresholds());
+
+		if (scene3d.getCurrentFrame() != scene3d.getPreviousFrame())
+		{
+			// The frame was moved by hand (slider or keys): continue from there
+			pipeline->seek(scene3d.getCurrentFrame());
+			scene3d.setPreviousFrame(scene3d.getCurrentFrame());
+		}
+		else if (scene3d.isPaused()
+				&& (scene3d.getHThreshold() != scene3d.getPHThreshold() || scene3d.getSThreshold() != scene3d.getPSThreshold()
+						|| scene3d.getVThreshold() != scene3d.getPVThreshold()))
+		{
+			// Process the frame again if one of the HSV sliders was moved (when the video is paused)
+			pipeline->seek(scene3d.getCurrentFrame());
+
+			scene3d.setPHThreshold(scene3d.getHThreshold());
+			scene3d.setPSThreshold(scene3d.getSThreshold());
+			scene3d.setPVThreshold(scene3d.getVThreshold());
+		}
+		else if (scene3d.isPaused() && snapshot != NULL && !pipeline->isSeeking()
+				&& snapshot->preview_camera != preview_camera)
+		{
+			// Process the frame again for the preview of another camera (when the video is paused)
+			pipeline->seek(scene3d.getCurrentFrame());
+		}
+		else if (snapshot != NULL && !pipeline->isSeeking())
+		{
+			// Follow the newest reconstruction
+			scene3d.setCurrentFrame(snapshot->number);
+			scene3d.setPreviousFrame(snapshot->number);
+		}
+	}
+	else if (scene3d.getCurrentFrame() != scene3d.getPreviousFrame())
 	{
 		// If the current frame is different from the last iteration update stuff
 		scene3d.processFrame();
@@ -636,30 +739,32 @@ void Glut::update(
 		arcball_add_angle(2);
 	}
 
-	// Get the image and the foreground image (of set camera)
-	Mat canvas, foreground;
-	if (scene3d.getCurrentCamera() != -1)
+	if (pipeline != NULL)
 	{
-		canvas = scene3d.getCameras()[scene3d.getCurrentCamera()]->getFrame();
-		foreground = scene3d.getCameras()[scene3d.getCurrentCamera()]->getForegroundImage();
+		// The preview of the newest reconstruction
+		if (snapshot != NULL && snapshot->preview_camera >= 0) imshow(VIDEO_WINDOW, snapshot->preview);
 	}
 	else
 	{
-		canvas = scene3d.getCameras()[scene3d.getPreviousCamera()]->getFrame();
-		foreground = scene3d.getCameras()[scene3d.getPreviousCamera()]->getForegroundImage();
-	}
+		// Get the image and the foreground image (of set camera)
+		const Camera* camera = scene3d.getCameras()[preview_camera];
+		const Mat &frame = camera->getFrame();
+		const Mat &foreground = camera->getForegroundImage();
 
-	// Concatenate the video frame with the foreground image (of set camera)
-	if (!canvas.empty() && !foreground.empty())
-	{
-		Mat fg_im_3c;
-		cvtColor(foreground, fg_im_3c, CV_GRAY2BGR);
-		hconcat(canvas, fg_im_3c, canvas);
-		imshow(VIDEO_WINDOW, canvas);
-	}
-	else if (!canvas.empty())
-	{
-		imshow(VIDEO_WINDOW, canvas);
+		// Concatenate the video frame with the foreground image (of set camera)
+		if (!frame.empty() && !foreground.empty())
+		{
+			Mat &canvas = m_Glut->m_canvas;
+			Scene3DRenderer::createPreview(frame, foreground, canvas);
+#ifdef DEBUG
+			if (steady) assert(AllocationCounter::getCount() == allocations);
+#endif
+			imshow(VIDEO_WINDOW, canvas);
+		}
+		else if (!frame.empty())
+		{
+			imshow(VIDEO_WINDOW, frame);
+		}
 	}
 
 	// Update the frame slider position
@@ -680,12 +785,78 @@ void Glut::update(
 
 
 
+/**
+ * Compile the static scene elements into display lists, so a redraw replays
+ * them instead of issuing every vertex again (in the GL context)
+ */
+void Glut::buildSceneLists()
+{
+	const GLuint lists = glGenLists(SCENE_LISTS);
+	if (lists == 0) return;
+
+	glNewList(lists + LIST_FLOOR, GL_COMPILE);
+	drawGrdGrid();
+	glEndList();
+
+	glNewList(lists + LIST_CAMERAS, GL_COMPILE);
+	drawCamCoord();
+	glEndList();
+
+	glNewList(lists + LIST_VOLUME, GL_COMPILE);
+	drawVolume();
+	glEndList();
+
+	glNewList(lists + LIST_ORIGIN, GL_COMPILE);
+	drawWCoord();
+	glEndList();
+
+	glNewList(lists + LIST_INFO, GL_COMPILE);
+	drawInfo();
+	glEndList();
+
+	m_Glut->m_scene_lists = lists;
+}
+
+/**
+ * Draw a static scene element, from its display list if the lists were built
+ */
+void Glut::drawSceneList(
+		SceneList list)
+{
+	if (m_Glut->m_scene_lists != 0)
+	{
+		glCallList(m_Glut->m_scene_lists + list);
+		return;
+	}
+
+	switch (list)
+	{
+	case LIST_FLOOR:
+		drawGrdGrid();
+		break;
+	case LIST_CAMERAS:
+		drawCamCoord();
+		break;
+	case LIST_VOLUME:
+		drawVolume();
+		break;
+	case LIST_ORIGIN:
+		drawWCoord();
+		break;
+	case LIST_INFO:
+		drawInfo();
+		break;
+	default:
+		break;
+	}
+}
+
 /**
  * Draw the floor
  */
 void Glut::drawGrdGrid()
 {
-	vector<vector<Point3i*> > floor_grid = m_Glut->getScene3d().getFloorGrid();
+	const vector<vector<Point3i*> > &floor_grid = m_Glut->getScene3d().getFloorGrid();
 
 	glLineWidth(1.0f);
 	glPushMatrix();
@@ -714,7 +885,7 @@ void Glut::drawGrdGrid()
  */
 void Glut::drawCamCoord()
 {
-	vector<Camera*> cameras = m_Glut->getScene3d().getCameras();
+	const vector<Camera*> &cameras = m_Glut->getScene3d().getCameras();
 
 	glLineWidth(1.0f);
 	glPushMatrix();
@@ -722,7 +893,7 @@ void Glut::drawCamCoord()
 
 	for (size_t i = 0; i < cameras.size(); i++)
 	{
-		vector<Point3f> plane = cameras[i]->getCameraPlane();
+		const vector<Point3f> &plane = cameras[i]->getCameraPlane();
 
 		// 0 - 1
 		glColor4f(0.8f, 0.8f, 0.8f, 0.5f);
@@ -774,7 +945,7 @@ void Glut::drawCamCoord()
  */
 void Glut::drawVolume()
 {
-	vector<Point3f*> corners = m_Glut->getScene3d().getReconstructor().getCorners();
+	const vector<Point3f*> &corners = m_Glut->getScene3d().getReconstructor().getCorners();
 
 	glLineWidth(1.0f);
 	glPushMatrix();
@@ -856,7 +1027,8 @@ void Glut::drawArcball()
 }
 
 /**
- * Draw all visible voxels
+ * Draw all visible voxels, from the vertex buffer that's only uploaded when
+ * the reconstruction changed
  */
 void Glut::drawVoxels()
 {
@@ -865,16 +1037,23 @@ void Glut::drawVoxels()
 	// apply default translation
 	glTranslatef(0, 0, 0);
 	glPointSize(2.0f);
-	glBegin(GL_POINTS);
 
-	vector<Reconstructor::Voxel*> voxels = m_Glut->getScene3d().getReconstructor().getVisibleVoxels();
-	for (size_t v = 0; v < voxels.size(); v++)
+	Scene3DRenderer &scene3d = m_Glut->getScene3d();
+	const Reconstructor &reconstructor = scene3d.getReconstructor();
+	FramePipeline* pipeline = m_Glut->m_pipeline;
+	if (pipeline != NULL)
 	{
-		glColor4f(0.5f, 0.5f, 0.5f, 0.5f);
-		glVertex3f((GLfloat) voxels[v]->x, (GLfloat) voxels[v]->y, (GLfloat) voxels[v]->z);
+		// The newest snapshot of the pipeline, without waiting for the stages
+		const FramePipeline::Snapshot* snapshot = pipeline->getSnapshot();
+		if (snapshot != NULL)
+			m_Glut->m_voxel_buffer.draw(snapshot->visible_voxels, snapshot->version, reconstructor, scene3d.isShowCubes());
+	}
+	else
+	{
+		m_Glut->m_voxel_buffer.draw(reconstructor.getVisibleVoxels(), reconstructor.getVisibleVersion(), reconstructor,
+				scene3d.isShowCubes());
 	}
 
-	glEnd();
 	glPopMatrix();
 }
 
@@ -922,18 +1101,15 @@ void Glut::drawInfo()
 	glPushMatrix();
 	glBegin(GL_BITMAP);
 
-	if (m_Glut->getScene3d().isShowInfo())
+	const vector<Camera*> &cameras = m_Glut->getScene3d().getCameras();
+	for (size_t c = 0; c < cameras.size(); ++c)
 	{
-		vector<Camera*> cameras = m_Glut->getScene3d().getCameras();
-		for (size_t c = 0; c < cameras.size(); ++c)
+		glRasterPos3d(cameras[c]->getCameraLocation().x, cameras[c]->getCameraLocation().y, cameras[c]->getCameraLocation().z);
+		stringstream sstext;
+		sstext << (c + 1) << "\0";
+		for (const char* c = sstext.str().c_str(); *c != '\0'; c++)
 		{
-			glRasterPos3d(cameras[c]->getCameraLocation().x, cameras[c]->getCameraLocation().y, cameras[c]->getCameraLocation().z);
-			stringstream sstext;
-			sstext << (c + 1) << "\0";
-			for (const char* c = sstext.str().c_str(); *c != '\0'; c++)
-			{
-				glutBitmapCharacter(GLUT_BITMAP_HELVETICA_12, *c);
-			}
+			glutBitmapCharacter(GLUT_BITMAP_HELVETICA_12, *c);
 		}
 	}
 
@@ -18,6 +18,10 @@
 #include <GL/glu.h>
 #endif
 
+#include <opencv2/core/core.hpp>
+
+#include "VoxelBuffer.h"
+
 // i am not sure about the compatibility with this...
 #define MOUSE_WHEEL_UP   3
 #define MOUSE_WHEEL_DOWN 4
@@ -26,10 +30,29 @@ namespace nl_uu_science_gmt
 {
 
 class Scene3DRenderer;
+class FramePipeline;
 
 class Glut
 {
+	/*
+	 * Display lists of the static scene elements, offsets from m_scene_lists
+	 */
+	enum SceneList
+	{
+		LIST_FLOOR,                          // Floor grid
+		LIST_CAMERAS,                        // Camera frusta
+		LIST_VOLUME,                         // Voxel volume box
+		LIST_ORIGIN,                         // World axes
+		LIST_INFO,                           // Camera numbers
+		SCENE_LISTS                          // Amount of scene lists
+	};
+
 	Scene3DRenderer &m_scene3d;
+	FramePipeline* m_pipeline;           // Staged frame processing, NULL to process frames in update()
+
+	cv::Mat m_canvas;                    // Video frame and foreground image side by side (serial, persistent)
+	VoxelBuffer m_voxel_buffer;          // Visible voxels on the GPU
+	GLuint m_scene_lists;                // First static scene display list, 0 until built (needs the GL context)
 
 	static Glut* m_Glut;
 
@@ -40,6 +63,9 @@ class Glut
 	static void drawVoxels();
 	static void drawWCoord();
 	static void drawInfo();
+	static void buildSceneLists();
+	static void drawSceneList(
+			SceneList);
 
 	static inline void perspectiveGL(
 			GLdouble, GLdouble, GLdouble, GLdouble);
@@ -51,7 +77,7 @@ class Glut
 
 public:
 	Glut(
-			Scene3DRenderer &);
+			Scene3DRenderer &, FramePipeline* = NULL);
 	virtual ~Glut();
 
 #ifdef __linux__
@@ -10,26 +10,151 @@
 #include <opencv2/core/mat.hpp>
 #include <opencv2/core/operations.hpp>
 #include <opencv2/core/types_c.h>
+#include <algorithm>
 #include <cassert>
+#include <climits>
+#include <cstring>
 #include <iostream>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 #include "../utilities/General.h"
 
+#ifdef HAVE_X86_SIMD
+#include <immintrin.h>
+#endif
+
 using namespace std;
 using namespace cv;
 
 namespace nl_uu_science_gmt
 {
 
+namespace
+{
+
+// Bitset words per compaction block (16384 voxels)
+const size_t COMPACTION_BLOCK_WORDS = 256;
+
+// Octree levels above the voxels, a top level node holds up to 16x16x16 voxels
+const int OCTREE_LEVELS = 4;
+
+/*
+ * FNV-1a hash of the given bytes, continuing from hash
+ */
+uint64_t fnv1a(
+		const void* data, size_t size, uint64_t hash = 14695981039346656037ULL)
+{
+	const unsigned char* bytes = (const unsigned char*) data;
+	for (size_t b = 0; b < size; ++b)
+		hash = (hash ^ bytes[b]) * 1099511628211ULL;
+	return hash;
+}
+
+uint64_t fnv1a(
+		const Mat &mat, uint64_t hash)
+{
+	const Mat continuous = mat.isContinuous() ? mat : mat.clone();
+	return fnv1a(continuous.ptr(), continuous.total() * continuous.elemSize(), hash);
+}
+
+/*
+ * Node count per axis of the octree level above the given one
+ */
+Point3i octreeParent(
+		const Point3i &dimensions)
+{
+	return Point3i((dimensions.x + 1) / 2, (dimensions.y + 1) / 2, (dimensions.z + 1) / 2);
+}
+
+/*
+ * Max-pool a binary image by 2x2 (odd edges pool with themselves)
+ */
+void maxPool(
+		const Mat &src, Mat &dst)
+{
+	for (int y = 0; y < dst.rows; ++y)
+	{
+		const uchar* row0 = src.ptr(2 * y);
+		const uchar* row1 = src.ptr(std::min(2 * y + 1, src.rows - 1));
+		uchar* out = dst.ptr(y);
+		for (int x = 0; x < dst.cols; ++x)
+		{
+			const int x1 = std::min(2 * x + 1, src.cols - 1);
+			out[x] = std::max(std::max(row0[2 * x], row0[x1]), std::max(row1[2 * x], row1[x1]));
+		}
+	}
+}
+
+/*
+ * acc[w] &= bits[w] for all words, 4 words per instruction
+ */
+#ifdef HAVE_X86_SIMD
+TARGET_AVX2 void andBitsAVX2(
+		uint64_t* acc, const uint64_t* bits, size_t words)
+{
+	size_t w = 0;
+	for (; w + 4 <= words; w += 4)
+	{
+		const __m256i a = _mm256_loadu_si256((const __m256i*) (acc + w));
+		const __m256i b = _mm256_loadu_si256((const __m256i*) (bits + w));
+		_mm256_storeu_si256((__m256i*) (acc + w), _mm256_and_si256(a, b));
+	}
+	for (; w < words; ++w)
+		acc[w] &= bits[w];
+}
+#endif
+
+/*
+ * acc[w] &= bits[w] for all words, with SSE2 or plain 64-bit words
+ */
+void andBits(
+		uint64_t* acc, const uint64_t* bits, size_t words)
+{
+	size_t w = 0;
+#ifdef HAVE_X86_SIMD
+	if (General::hasAVX2())
+	{
+		andBitsAVX2(acc, bits, words);
+		return;
+	}
+	for (; w + 2 <= words; w += 2)
+	{
+		const __m128i a = _mm_loadu_si128((const __m128i*) (acc + w));
+		const __m128i b = _mm_loadu_si128((const __m128i*) (bits + w));
+		_mm_storeu_si128((__m128i*) (acc + w), _mm_and_si128(a, b));
+	}
+#endif
+	for (; w < words; ++w)
+		acc[w] &= bits[w];
+}
+
+} /* namespace */
+
+/**
+ * Default volume: [(-2048, 2048), (-2048, 2048), (0, 2048)] with 32mm steps
+ */
+Reconstructor::Volume::Volume() :
+		min(-2048, -2048, 0),
+		max(2048, 2048, 2048),
+		step(32, 32, 32),
+		memory_budget(0),
+		downscale(true)
+{
+}
+
 /**
  * Constructor
  * Voxel reconstruction class
  */
 Reconstructor::Reconstructor(
-		const vector<Camera*> &cs) :
+		const vector<Camera*> &cs, const Volume &volume) :
 				m_cameras(cs),
-				m_height(2048),
-				m_step(32)
+				m_volume(volume),
+				m_visible_version(0),
+				m_carving_mode(CARVING_FLAT),
+				m_update_time(0)
 {
 	for (size_t c = 0; c < m_cameras.size(); ++c)
 	{
@@ -39,42 +164,189 @@ Reconstructor::Reconstructor(
 			m_plane_size = m_cameras[c]->getSize();
 	}
 
-	const size_t edge = 2 * m_height;
-	m_voxels_amount = (edge / m_step) * (edge / m_step) * (m_height / m_step);
+	m_dimensions = getDimensions(m_volume);
+	m_foregrounds.resize(m_cameras.size());
 
 	initialize();
+
+	// Size the bitsets for the voxels that survived culling
+	const size_t words = (m_voxels_amount + 63) / 64;
+	m_visible_bits.resize(words);
+	m_camera_bits.resize(words);
+	m_incremental_bits.resize(words);
+	m_block_offsets.resize((words + COMPACTION_BLOCK_WORDS - 1) / COMPACTION_BLOCK_WORDS + 1);
+
+	// Reserve room for all voxels being visible so carving never reallocates
+	// (untouched pages of the reservation take no physical memory)
+	m_visible_voxels.reserve(m_voxels_amount);
 }
 
 /**
  * Deconstructor
- * Free the memory of the pointer vectors
+ * Free the memory of the corners pointer vector
  */
 Reconstructor::~Reconstructor()
 {
 	for (size_t c = 0; c < m_corners.size(); ++c)
 		delete m_corners.at(c);
-	for (size_t v = 0; v < m_voxels.size(); ++v)
-		delete m_voxels.at(v);
+}
+
+/**
+ * Read the volume bounds, steps and memory budget from an XML file,
+ * keys missing from the file keep their current value
+ */
+bool Reconstructor::readVolume(
+		const string &filename, Volume &volume)
+{
+	FileStorage fs;
+	fs.open(filename, FileStorage::READ);
+	if (!fs.isOpened()) return false;
+
+	const char* keys[] = { "VolumeMinX", "VolumeMinY", "VolumeMinZ", "VolumeMaxX", "VolumeMaxY", "VolumeMaxZ", "StepX", "StepY", "StepZ" };
+	int* values[] = { &volume.min.x, &volume.min.y, &volume.min.z, &volume.max.x, &volume.max.y, &volume.max.z, &volume.step.x,
+			&volume.step.y, &volume.step.z };
+	for (size_t k = 0; k < sizeof(keys) / sizeof(keys[0]); ++k)
+	{
+		if (!fs[keys[k]].empty()) fs[keys[k]] >> *values[k];
+	}
+	if (!fs["MemoryBudget"].empty()) fs["MemoryBudget"] >> volume.memory_budget;
+	if (!fs["DownscaleToBudget"].empty())
+	{
+		int downscale;
+		fs["DownscaleToBudget"] >> downscale;
+		volume.downscale = downscale != 0;
+	}
+	fs.release();
+
+	return true;
+}
+
+/**
+ * Voxel count per axis of the given volume
+ */
+Point3i Reconstructor::getDimensions(
+		const Volume &volume)
+{
+	return Point3i(
+			(volume.max.x - volume.min.x + volume.step.x - 1) / volume.step.x,
+			(volume.max.y - volume.min.y + volume.step.y - 1) / volume.step.y,
+			(volume.max.z - volume.min.z + volume.step.z - 1) / volume.step.z);
+}
+
+/**
+ * Bytes the voxel LUTs of the given volume take for the given amount of cameras
+ */
+size_t Reconstructor::estimateMemory(
+		const Volume &volume, size_t cameras)
+{
+	const Point3i dimensions = getDimensions(volume);
+	const size_t voxels = (size_t) dimensions.x * dimensions.y * dimensions.z;
+
+	// coordinates + a pixel offset per camera + two occupancy bitsets + the grid index
+	// (an upper bound, voxels outside the FoV of any camera are culled)
+	size_t memory = voxels * (3 * sizeof(int) + cameras * sizeof(int)) + 2 * ((voxels + 63) / 64) * sizeof(uint64_t)
+			+ voxels * sizeof(int);
+
+	// + the inverse LUT voxel lists, the camera counters and the bitset of incremental carving
+	memory += voxels * (cameras * sizeof(int) + sizeof(uchar)) + ((voxels + 63) / 64) * sizeof(uint64_t);
+
+	// + octree pixel boxes per camera
+	Point3i level = dimensions;
+	for (int l = 1; l <= OCTREE_LEVELS; ++l)
+	{
+		level = octreeParent(level);
+		memory += (size_t) level.x * level.y * level.z * cameras * 4 * sizeof(short);
+	}
+
+	return memory;
+}
+
+/**
+ * Check the volume before anything is allocated:
+ * - refuse a malformed volume
+ * - report the voxel count, the LUT memory and an estimate of the LUT build time
+ * - if the memory exceeds the budget, either refuse or coarsen the step of the
+ *   axis with the most voxels until it fits
+ */
+bool Reconstructor::fitVolume(
+		Volume &volume, const vector<Camera*> &cameras)
+{
+	if (volume.step.x <= 0 || volume.step.y <= 0 || volume.step.z <= 0 || volume.max.x <= volume.min.x
+			|| volume.max.y <= volume.min.y || volume.max.z <= volume.min.z)
+	{
+		cerr << "Invalid voxel volume: bounds " << volume.min << " - " << volume.max << ", steps " << volume.step << endl;
+		return false;
+	}
+
+	const double MB = 1024.0 * 1024.0;
+	double memory = estimateMemory(volume, cameras.size()) / MB;
+	while (volume.memory_budget > 0 && memory > volume.memory_budget)
+	{
+		// Coarsening stops helping once every axis is down to one voxel
+		const Point3i dimensions = getDimensions(volume);
+		if (!volume.downscale || (dimensions.x <= 1 && dimensions.y <= 1 && dimensions.z <= 1))
+		{
+			cerr << "Voxel volume needs " << memory << "MB, exceeding the budget of " << volume.memory_budget << "MB" << endl;
+			return false;
+		}
+
+		if (dimensions.x >= dimensions.y && dimensions.x >= dimensions.z)
+			volume.step.x *= 2;
+		else if (dimensions.y >= dimensions.z)
+			volume.step.y *= 2;
+		else
+			volume.step.z *= 2;
+
+		memory = estimateMemory(volume, cameras.size()) / MB;
+		cout << "Downscaled voxel steps to " << volume.step << " to fit the memory budget" << endl;
+	}
+
+	// Time a batch of sample projections to estimate the LUT build time
+	const int samples = 1024;
+	vector<Point3f> sample_points(samples);
+	vector<Point2f> sample_projections(samples);
+	for (int s = 0; s < samples; ++s)
+	{
+		sample_points[s] = Point3f(
+				volume.min.x + (volume.max.x - volume.min.x) * (s % 16) / 16.f,
+				volume.min.y + (volume.max.y - volume.min.y) * ((s / 16) % 8) / 8.f,
+				volume.min.z + (volume.max.z - volume.min.z) * (s / 128) / 8.f);
+	}
+	const int64 start = getTickCount();
+	cameras.front()->projectOnView(sample_points.data(), sample_projections.data(), samples);
+	const double projection_time = (getTickCount() - start) / getTickFrequency() / samples;
+
+	int threads = 1;
+#ifdef _OPENMP
+	threads = omp_get_max_threads();
+#endif
+
+	const Point3i dimensions = getDimensions(volume);
+	const double voxels = (double) dimensions.x * dimensions.y * dimensions.z;
+	cout << "Voxel volume " << volume.min << " - " << volume.max << ", steps " << volume.step << ": " << dimensions.x << "x"
+			<< dimensions.y << "x" << dimensions.z << " voxels, " << memory << "MB, ~"
+			<< voxels * cameras.size() * projection_time / threads << "s to build (unless cached)" << endl;
+
+	return true;
 }
 
 /**
  * Create some Look Up Tables
  * 	- LUT for the scene's box corners
- * 	- LUT with a map of the entire voxelspace: point-on-cam to voxels
+ * 	- LUT with a map of the entire voxelspace: point-on-cam to voxels (see initializeInverseLut)
  * 	- LUT with a map of the entire voxelspace: voxel to cam points-on-cam
  */
 void Reconstructor::initialize()
 {
-	// Cube dimensions from [(-m_height, m_height), (-m_height, m_height), (0, m_height)]
-	const int xL = -m_height;
-	const int xR = m_height;
-	const int yL = -m_height;
-	const int yR = m_height;
-	const int zL = 0;
-	const int zR = m_height;
-	const int plane_y = (yR - yL) / m_step;
-	const int plane_x = (xR - xL) / m_step;
-	const int plane = plane_y * plane_x;
+	// Volume dimensions from [(xL, xR), (yL, yR), (zL, zR)]
+	const int xL = m_volume.min.x;
+	const int xR = m_volume.max.x;
+	const int yL = m_volume.min.y;
+	const int yR = m_volume.max.y;
+	const int zL = m_volume.min.z;
+	const int zR = m_volume.max.z;
+	const int plane_x = m_dimensions.x;
+	const int plane = m_dimensions.y * plane_x;
 
 	// Save the 8 volume corners
 	// bottom
@@ -89,17 +361,37 @@ void Reconstructor::initialize()
 	m_corners.push_back(new Point3f((float) xR, (float) yR, (float) zR));
 	m_corners.push_back(new Point3f((float) xR, (float) yL, (float) zR));
 
-	// Acquire some memory for efficiency
-	cout << "Initializing " << m_voxels_amount << " voxels ";
-	m_voxels.resize(m_voxels_amount);
+	// Map the voxel LUT from the cache if it was built for the same calibration and volume
+	const size_t grid_amount = (size_t) m_dimensions.x * m_dimensions.y * m_dimensions.z;
+	const string cache_file = m_cameras.front()->getDataPath() + ".." + string(PATH_SEP) + General::VoxelCacheFile;
+	const uint64_t key = getLutKey();
+	if (m_voxels.load(cache_file, key, m_cameras.size(), m_plane_size.width) && m_voxels.size() <= grid_amount
+			&& isLutInRange())
+	{
+		m_voxels_amount = m_voxels.size();
+		cout << "Mapped " << m_voxels_amount << " voxels (" << grid_amount - m_voxels_amount << " culled) from " << cache_file
+				<< endl;
+		initializeGridIndex();
+		initializeOctree();
+		initializeInverseLut();
+		return;
+	}
+
+	cout << "Initializing " << grid_amount << " voxels ";
 
-	int z;
+	// Per z-slice: the in-slice index of every voxel within the FoV of all cameras
+	// and its pixel offsets, camera-major. Voxels outside the FoV of any camera
+	// can never become visible, so they are culled here and never stored.
+	vector<vector<int> > slice_voxels(m_dimensions.z);
+	vector<vector<int> > slice_offsets(m_dimensions.z);
+
+	int zp;
 	int pdone = 0;
-#pragma omp parallel for schedule(auto) private(z) shared(pdone)
-	for (z = zL; z < zR; z += m_step)
+#pragma omp parallel for schedule(auto) private(zp) shared(pdone)
+	for (zp = 0; zp < m_dimensions.z; ++zp)
 	{
-		const int zp = (z - zL) / m_step;
-		int done = cvRound((zp * plane / (double) m_voxels_amount) * 100.0);
+		const int z = zL + zp * m_volume.step.z;
+		int done = cvRound((zp * plane / (double) grid_amount) * 100.0);
 
 #pragma omp critical
 		if (done > pdone)
@@ -108,83 +400,805 @@ void Reconstructor::initialize()
 			cout << done << "%..." << flush;
 		}
 
-		int y, x;
-		for (y = yL; y < yR; y += m_step)
+		// Project the whole z-slice at once on every camera
+		vector<Point3f> slice(plane);
+		vector<Point2f> projections(plane);
+		vector<int> offsets(m_cameras.size() * plane);
+		vector<uchar> in_view(plane, 1);
+
+		for (int yp = 0; yp < m_dimensions.y; ++yp)
+		{
+			const int y = yL + yp * m_volume.step.y;
+
+			for (int xp = 0; xp < m_dimensions.x; ++xp)
+			{
+				const int x = xL + xp * m_volume.step.x;
+				slice[yp * plane_x + xp] = Point3f((float) x, (float) y, (float) z);
+			}
+		}
+
+		for (size_t c = 0; c < m_cameras.size(); ++c)
+		{
+			m_cameras[c]->projectOnView(slice.data(), projections.data(), slice.size());
+
+			for (int p = 0; p < plane; ++p)
+			{
+				const Point point = projections[p];
+
+				// Save the linear pixel offset of the voxel projection on camera 'c'
+				// if it's within the camera's FoV, otherwise cull the voxel
+				if (point.x >= 0 && point.x < m_plane_size.width && point.y >= 0 && point.y < m_plane_size.height)
+					offsets[c * plane + p] = point.y * m_plane_size.width + point.x;
+				else
+					in_view[p] = 0;
+			}
+		}
+
+		//Writing slice 'zp' is not critical as it's unique (thread safe)
+		for (int p = 0; p < plane; ++p)
+			if (in_view[p]) slice_voxels[zp].push_back(p);
+
+		const size_t kept = slice_voxels[zp].size();
+		slice_offsets[zp].resize(m_cameras.size() * kept);
+		for (size_t c = 0; c < m_cameras.size(); ++c)
+			for (size_t k = 0; k < kept; ++k)
+				slice_offsets[zp][c * kept + k] = offsets[c * plane + slice_voxels[zp][k]];
+	}
+
+	// Store the remaining voxels contiguously in grid order
+	vector<int> slice_first(m_dimensions.z + 1, 0);
+	for (zp = 0; zp < m_dimensions.z; ++zp)
+		slice_first[zp + 1] = slice_first[zp] + (int) slice_voxels[zp].size();
+
+	m_voxels_amount = slice_first[m_dimensions.z];
+	m_voxels.resize(m_voxels_amount, m_cameras.size(), m_plane_size.width);
+
+#pragma omp parallel for schedule(static) private(zp)
+	for (zp = 0; zp < m_dimensions.z; ++zp)
+	{
+		const int z = zL + zp * m_volume.step.z;
+		const size_t kept = slice_voxels[zp].size();
+
+		for (size_t k = 0; k < kept; ++k)
+		{
+			const int p = slice_voxels[zp][k];
+			const int v = slice_first[zp] + (int) k;
+			m_voxels.setVoxel(v, xL + (p % plane_x) * m_volume.step.x, yL + (p / plane_x) * m_volume.step.y, z);
+
+			for (size_t c = 0; c < m_cameras.size(); ++c)
+				m_voxels.setOffset(c, v, slice_offsets[zp][c * kept + k]);
+		}
+
+		vector<int>().swap(slice_voxels[zp]);
+		vector<int>().swap(slice_offsets[zp]);
+	}
+
+	cout << "done!" << endl;
+	cout << "Culled " << grid_amount - m_voxels_amount << " of " << grid_amount
+			<< " voxels outside the FoV of at least one camera" << endl;
+
+	if (!m_voxels.save(cache_file, key)) cerr << "Unable to write voxel LUT cache: " << cache_file << endl;
+
+	initializeGridIndex();
+	initializeOctree();
+	initializeInverseLut();
+}
+
+/**
+ * Key of the voxel LUT: a hash of the LUT generation method, the volume, the
+ * camera FoV plane size and every camera's projection path, matrix, distortion,
+ * rotation and translation. The projection kernel and cv::projectPoints may
+ * round a few voxels to other pixels, so a LUT of one isn't valid for the other.
+ */
+uint64_t Reconstructor::getLutKey() const
+{
+	const string method = "cvRound+FoVCulling";
+	uint64_t key = fnv1a(method.data(), method.size());
+
+	const int volume[] = { m_volume.min.x, m_volume.min.y, m_volume.min.z, m_volume.max.x, m_volume.max.y, m_volume.max.z,
+			m_volume.step.x, m_volume.step.y, m_volume.step.z, m_plane_size.width, m_plane_size.height };
+	key = fnv1a(volume, sizeof(volume), key);
+
+	for (size_t c = 0; c < m_cameras.size(); ++c)
+	{
+		const string projection = m_cameras[c]->hasProjectionKernel() ? "Projection" : "projectPoints";
+		key = fnv1a(projection.data(), projection.size(), key);
+		key = fnv1a(m_cameras[c]->getCameraMatrix(), key);
+		key = fnv1a(m_cameras[c]->getDistortionCoeffs(), key);
+		key = fnv1a(m_cameras[c]->getRotationValues(), key);
+		key = fnv1a(m_cameras[c]->getTranslationValues(), key);
+	}
+
+	return key;
+}
+
+/**
+ * Check that every voxel of the (mapped) LUT lies on a cell of the grid and every
+ * pixel offset falls inside the camera plane, as they index the grid and the
+ * foreground images unchecked. A stale or damaged cache fails this and is rebuilt.
+ */
+bool Reconstructor::isLutInRange() const
+{
+	const int pixels = m_plane_size.area();
+	const int* coordinates[] = { m_voxels.getX(), m_voxels.getY(), m_voxels.getZ() };
+	const int mins[] = { m_volume.min.x, m_volume.min.y, m_volume.min.z };
+	const int steps[] = { m_volume.step.x, m_volume.step.y, m_volume.step.z };
+	const int cells[] = { m_dimensions.x, m_dimensions.y, m_dimensions.z };
+
+	for (int a = 0; a < 3; ++a)
+		for (size_t v = 0; v < m_voxels.size(); ++v)
 		{
-			const int yp = (y - yL) / m_step;
+			const int distance = coordinates[a][v] - mins[a];
+			if (distance < 0 || distance % steps[a] != 0 || distance / steps[a] >= cells[a])
+			{
+				cerr << "Voxel " << v << " of the LUT cache is outside the volume, rebuilding" << endl;
+				return false;
+			}
+		}
 
-			for (x = xL; x < xR; x += m_step)
+	for (size_t c = 0; c < m_voxels.getCamerasAmount(); ++c)
+	{
+		const int* offsets = m_voxels.getOffsets(c);
+		for (size_t v = 0; v < m_voxels.size(); ++v)
+			if (offsets[v] < VoxelStore::OUTSIDE_FOV || offsets[v] >= pixels)
 			{
-				const int xp = (x - xL) / m_step;
+				cerr << "Voxel " << v << " of the LUT cache projects outside camera " << c + 1 << ", rebuilding" << endl;
+				return false;
+			}
+	}
+
+	return true;
+}
+
+/**
+ * Map every cell of the voxel grid to its voxel in the store, or -1 if it was culled
+ */
+void Reconstructor::initializeGridIndex()
+{
+	m_grid_index.assign((size_t) m_dimensions.x * m_dimensions.y * m_dimensions.z, -1);
+
+	const int* xs = m_voxels.getX();
+	const int* ys = m_voxels.getY();
+	const int* zs = m_voxels.getZ();
+	for (int v = 0; v < (int) m_voxels_amount; ++v)
+	{
+		const int xp = (xs[v] - m_volume.min.x) / m_volume.step.x;
+		const int yp = (ys[v] - m_volume.min.y) / m_volume.step.y;
+		const int zp = (zs[v] - m_volume.min.z) / m_volume.step.z;
+		m_grid_index[((size_t) zp * m_dimensions.y + yp) * m_dimensions.x + xp] = v;
+	}
+}
 
-				// Create all voxels
-				Voxel* voxel = new Voxel;
-				voxel->x = x;
-				voxel->y = y;
-				voxel->z = z;
-				voxel->camera_projection = vector<Point>(m_cameras.size());
-				voxel->valid_camera_projection = vector<int>(m_cameras.size(), 0);
+/**
+ * Create the octree LUT: for every block of 2x2x2, 4x4x4, ... voxels the pixel box
+ * around the projections of its voxels on each camera. Culled grid cells are
+ * skipped. The boxes are built from the voxel LUT itself, so a voxel's
+ * projection is always inside its blocks' boxes.
+ */
+void Reconstructor::initializeOctree()
+{
+	const size_t cameras_amount = m_cameras.size();
+	PixelBox empty = { SHRT_MAX, SHRT_MAX, SHRT_MIN, SHRT_MIN };
 
-				const int p = zp * plane + yp * plane_x + xp;  // The voxel's index
+	m_octree_dimensions.assign(1, m_dimensions);
+	m_octree_boxes.assign(1, vector<PixelBox>());
+	for (int l = 1; l <= OCTREE_LEVELS; ++l)
+	{
+		const Point3i children = m_octree_dimensions[l - 1];
+		const Point3i nodes = octreeParent(children);
+		const size_t nodes_amount = (size_t) nodes.x * nodes.y * nodes.z;
+		m_octree_dimensions.push_back(nodes);
+		m_octree_boxes.push_back(vector<PixelBox>(cameras_amount * nodes_amount, empty));
+
+		vector<PixelBox> &boxes = m_octree_boxes[l];
+		const vector<PixelBox> &child_boxes = m_octree_boxes[l - 1];
+		const size_t children_amount = (size_t) children.x * children.y * children.z;
 
-				for (size_t c = 0; c < m_cameras.size(); ++c)
+		int z;
+#pragma omp parallel for schedule(static) private(z)
+		for (z = 0; z < nodes.z; ++z)
+		{
+			for (int y = 0; y < nodes.y; ++y)
+			{
+				for (int x = 0; x < nodes.x; ++x)
 				{
-					Point point = m_cameras[c]->projectOnView(Point3f((float) x, (float) y, (float) z));
+					const size_t node = ((size_t) z * nodes.y + y) * nodes.x + x;
+
+					for (int cz = 2 * z; cz < std::min(2 * z + 2, children.z); ++cz)
+						for (int cy = 2 * y; cy < std::min(2 * y + 2, children.y); ++cy)
+							for (int cx = 2 * x; cx < std::min(2 * x + 2, children.x); ++cx)
+							{
+								const int child = (cz * children.y + cy) * children.x + cx;
+
+								// Skip culled voxels
+								if (l == 1 && m_grid_index[child] < 0) continue;
 
-					// Save the pixel coordinates 'point' of the voxel projection on camera 'c'
-					voxel->camera_projection[(int) c] = point;
+								for (size_t c = 0; c < cameras_amount; ++c)
+								{
+									PixelBox child_box;
+									if (l == 1)
+									{
+										const Point point = m_voxels.getProjection(c, m_grid_index[child]);
+										child_box.x0 = child_box.x1 = (short) point.x;
+										child_box.y0 = child_box.y1 = (short) point.y;
+									}
+									else
+									{
+										child_box = child_boxes[c * children_amount + child];
+										if (child_box.x0 > child_box.x1) break;
+									}
 
-					// If it's within the camera's FoV, flag the projection
-					if (point.x >= 0 && point.x < m_plane_size.width && point.y >= 0 && point.y < m_plane_size.height)
-						voxel->valid_camera_projection[(int) c] = 1;
+									PixelBox &box = boxes[c * nodes_amount + node];
+									box.x0 = std::min(box.x0, child_box.x0);
+									box.y0 = std::min(box.y0, child_box.y0);
+									box.x1 = std::max(box.x1, child_box.x1);
+									box.y1 = std::max(box.y1, child_box.y1);
+								}
+							}
 				}
+			}
+		}
+	}
+
+	// Max-pooled foreground pyramids down to a few pixels
+	m_fg_pyramids.assign(cameras_amount, vector<Mat>(1));
+	for (size_t c = 0; c < cameras_amount; ++c)
+	{
+		Size size = m_plane_size;
+		while (size.width > 4 && size.height > 4)
+		{
+			size = Size((size.width + 1) / 2, (size.height + 1) / 2);
+			m_fg_pyramids[c].push_back(Mat(size, CV_8U));
+		}
+	}
+}
+/**
+ * Create the inverse LUT of each camera in CSR form: the voxels that project on
+ * pixel p of camera c are m_pixel_voxels[c][m_pixel_starts[c][p] .. m_pixel_starts[c][p + 1])
+ */
+void Reconstructor::initializeInverseLut()
+{
+	const size_t pixels = (size_t) m_plane_size.area();
+	m_pixel_starts.assign(m_cameras.size(), vector<int>());
+	m_pixel_voxels.assign(m_cameras.size(), vector<int>());
+
+	int c;
+#pragma omp parallel for schedule(static) private(c)
+	for (c = 0; c < (int) m_cameras.size(); ++c)
+	{
+		const int* offsets = m_voxels.getOffsets(c);
+		vector<int> &starts = m_pixel_starts[c];
+		vector<int> &voxels = m_pixel_voxels[c];
+		starts.assign(pixels + 1, 0);
+		voxels.resize(m_voxels_amount);
+
+		// Counting sort of the voxels by pixel offset, voxels stay in index order per pixel
+		for (size_t v = 0; v < m_voxels_amount; ++v)
+			++starts[offsets[v] + 1];
+		for (size_t p = 0; p < pixels; ++p)
+			starts[p + 1] += starts[p];
+
+		vector<int> next(starts.begin(), starts.end() - 1);
+		for (size_t v = 0; v < m_voxels_amount; ++v)
+			voxels[next[offsets[v]]++] = (int) v;
+	}
+
+	// The incremental state is built on its first use
+	vector<vector<uchar> >().swap(m_previous_foregrounds);
+}
+
+/**
+ * Human readable name of a carving mode
+ */
+const char* Reconstructor::getCarvingModeName(
+		CarvingMode mode)
+{
+	switch (mode)
+	{
+	case CARVING_FLAT:
+		return "flat";
+	case CARVING_BITSET:
+		return "bitset";
+	case CARVING_OCTREE:
+		return "octree";
+	case CARVING_INCREMENTAL:
+		return "incremental";
+	default:
+		return "unknown";
+	}
+}
 
-				//Writing voxel 'p' is not critical as it's unique (thread safe)
-				m_voxels[p] = voxel;
+/**
+ * Fetch the foreground image data of the current frame of each camera,
+ * the voxels address it through their linear pixel offsets
+ */
+void Reconstructor::updateForegrounds()
+{
+	for (size_t c = 0; c < m_cameras.size(); ++c)
+	{
+		const Mat &foreground = m_cameras[c]->getForegroundImage();
+		assert(foreground.isContinuous() && foreground.cols == m_plane_size.width);
+		m_foregrounds[c] = foreground.ptr();
+	}
+}
+
+/**
+ * Carve the voxel space with the active carving engine
+ */
+void Reconstructor::update()
+{
+	updateForegrounds();
+	m_update_time = update(m_foregrounds, m_visible_voxels);
+	++m_visible_version;
+}
+
+/**
+ * Carve the voxel space with the active carving engine from the given foreground
+ * image data per camera into visible_voxels, returns the duration (ms).
+ * Leaves the visible voxels alone, so a pipeline stage can carve the next frame
+ * while the current one is shown.
+ */
+double Reconstructor::update(
+		const std::vector<const uchar*> &foregrounds, std::vector<Voxel> &visible_voxels)
+{
+	const int64 start = getTickCount();
+	m_foregrounds = foregrounds;
+	carve(m_carving_mode, visible_voxels);
+	return (getTickCount() - start) * 1000.0 / getTickFrequency();
+}
+
+/**
+ * Keep the voxels of the given set that lie on its surface: voxels with at
+ * least one of their 6 neighbours outside the set (empty, culled or outside
+ * the volume). Voxels inside a solid shape can't be seen, so a renderer only
+ * needs the shell. Uses the caller's membership bitset scratch, so it only
+ * reads the LUT and can run next to carving.
+ */
+void Reconstructor::extractSurface(
+		const std::vector<Voxel> &voxels, std::vector<Voxel> &surface, std::vector<uint64_t> &membership) const
+{
+	membership.assign((m_voxels_amount + 63) / 64, 0);
+	for (size_t v = 0; v < voxels.size(); ++v)
+		membership[voxels[v].index >> 6] |= (uint64_t) 1 << (voxels[v].index & 63);
+
+	const uint64_t* bits = membership.data();
+	const int* grid = m_grid_index.data();
+	const int X = m_dimensions.x, Y = m_dimensions.y, Z = m_dimensions.z;
+	const size_t plane = (size_t) X * Y;
+
+	surface.clear();
+	for (size_t v = 0; v < voxels.size(); ++v)
+	{
+		const Voxel &voxel = voxels[v];
+		const int xp = (voxel.x - m_volume.min.x) / m_volume.step.x;
+		const int yp = (voxel.y - m_volume.min.y) / m_volume.step.y;
+		const int zp = (voxel.z - m_volume.min.z) / m_volume.step.z;
+		if (xp == 0 || yp == 0 || zp == 0 || xp == X - 1 || yp == Y - 1 || zp == Z - 1)
+		{
+			surface.push_back(voxel);
+			continue;
+		}
+
+		const size_t cell = (size_t) zp * plane + (size_t) yp * X + xp;
+		const size_t neighbours[6] = { cell - 1, cell + 1, cell - X, cell + X, cell - plane, cell + plane };
+		for (int n = 0; n < 6; ++n)
+		{
+			const int index = grid[neighbours[n]];
+			if (index < 0 || !(bits[index >> 6] >> (index & 63) & 1))
+			{
+				surface.push_back(voxel);
+				break;
 			}
 		}
 	}
+}
 
-	cout << "done!" << endl;
+/**
+ * Carve the voxel space with the given engine into visible_voxels
+ */
+void Reconstructor::carve(
+		CarvingMode mode, std::vector<Voxel> &visible_voxels)
+{
+	switch (mode)
+	{
+	case CARVING_BITSET:
+		carveBitset(visible_voxels);
+		break;
+	case CARVING_OCTREE:
+		carveOctree(visible_voxels);
+		break;
+	case CARVING_INCREMENTAL:
+		carveIncremental(visible_voxels);
+		break;
+	default:
+		carveFlat(visible_voxels);
+		break;
+	}
+}
+
+/**
+ * Run every carving engine on the current frame and report its timing and
+ * whether it yields the same voxel set as the flat engine
+ */
+void Reconstructor::compareCarving()
+{
+	updateForegrounds();
+	compareCarving(m_foregrounds);
+}
+
+/**
+ * Run every carving engine on the given foreground image data per camera
+ */
+void Reconstructor::compareCarving(
+		const std::vector<const uchar*> &foregrounds)
+{
+	m_foregrounds = foregrounds;
+
+	vector<int> reference;
+	vector<Voxel> visible_voxels;
+	for (int m = 0; m < CARVING_MODES; ++m)
+	{
+		const int64 start = getTickCount();
+		carve((CarvingMode) m, visible_voxels);
+		const double time = (getTickCount() - start) * 1000.0 / getTickFrequency();
+
+		vector<int> indices(visible_voxels.size());
+		for (size_t v = 0; v < visible_voxels.size(); ++v)
+			indices[v] = visible_voxels[v].index;
+		sort(indices.begin(), indices.end());
+		if (m == CARVING_FLAT) reference = indices;
+
+		cout << "Carving " << getCarvingModeName((CarvingMode) m) << ": " << indices.size() << " voxels in " << time << "ms"
+				<< (indices == reference ? "" : " (MISMATCH with flat)") << endl;
+	}
 }
 
 /**
  * Count the amount of camera's each voxel in the space appears on,
- * if that amount equals the amount of cameras, add that voxel to the
- * visible_voxels vector
+ * if that amount equals the amount of cameras, flag that voxel in the
+ * visible voxels bitset. All stored voxels are within the FoV of every camera.
  */
-void Reconstructor::update()
+void Reconstructor::carveFlat(
+		std::vector<Voxel> &visible_voxels)
 {
-	m_visible_voxels.clear();
-	std::vector<Voxel*> visible_voxels;
+	const size_t cameras_amount = m_cameras.size();
+	const size_t words = m_visible_bits.size();
 
-	int v;
-#pragma omp parallel for schedule(auto) private(v) shared(visible_voxels)
-	for (v = 0; v < (int) m_voxels_amount; ++v)
+	// Every thread writes whole 64-voxel words of the bitset (thread safe)
+	int w;
+#pragma omp parallel for schedule(static) private(w)
+	for (w = 0; w < (int) words; ++w)
 	{
-		int camera_counter = 0;
-		Voxel* voxel = m_voxels[v];
+		const size_t first = (size_t) w * 64;
+		const int last = (int) std::min<size_t>(64, m_voxels_amount - first);
 
-		for (size_t c = 0; c < m_cameras.size(); ++c)
+		uint64_t word = 0;
+		for (int b = 0; b < last; ++b)
 		{
-			if (voxel->valid_camera_projection[c])
+			const size_t v = first + b;
+			size_t camera_counter = 0;
+
+			// Stop at the first camera that doesn't see a white pixel at the projection point
+			for (; camera_counter < cameras_amount; ++camera_counter)
 			{
-				const Point point = voxel->camera_projection[c];
+				if (m_foregrounds[camera_counter][m_voxels.getOffsets(camera_counter)[v]] != 255) break;
+			}
+
+			// If the voxel is present on all cameras
+			if (camera_counter == cameras_amount) word |= (uint64_t) 1 << b;
+		}
+		m_visible_bits[w] = word;
+	}
+
+	compactVisibleBits(m_visible_bits, visible_voxels);
+}
 
-				//If there's a white pixel on the foreground image at the projection point, add the camera
-				if (m_cameras[c]->getForegroundImage().at<uchar>(point) == 255) ++camera_counter;
+/**
+ * Build an occupancy bitset per camera (a bit per voxel that projects on a
+ * white pixel) and AND-reduce them into the visible voxels bitset.
+ * Camera 0 scans all voxels, the next cameras only scan the 64-voxel words
+ * that still have bits set.
+ */
+void Reconstructor::carveBitset(
+		std::vector<Voxel> &visible_voxels)
+{
+	const size_t words = m_visible_bits.size();
+
+	for (size_t c = 0; c < m_cameras.size(); ++c)
+	{
+		const int* offsets = m_voxels.getOffsets(c);
+		const uchar* foreground = m_foregrounds[c];
+		uint64_t* bits = c == 0 ? m_visible_bits.data() : m_camera_bits.data();
+		const uint64_t* visible_bits = m_visible_bits.data();
+
+		int w;
+#pragma omp parallel for schedule(static) private(w)
+		for (w = 0; w < (int) words; ++w)
+		{
+			uint64_t word = 0;
+			if (c == 0 || visible_bits[w])
+			{
+				const size_t first = (size_t) w * 64;
+				const int last = (int) std::min<size_t>(64, m_voxels_amount - first);
+				for (int b = 0; b < last; ++b)
+				{
+					if (foreground[offsets[first + b]] == 255) word |= (uint64_t) 1 << b;
+				}
 			}
+			bits[w] = word;
 		}
 
-		// If the voxel is present on all cameras
-		if (camera_counter == m_cameras.size())
+		if (c > 0) andBits(m_visible_bits.data(), m_camera_bits.data(), words);
+	}
+
+	compactVisibleBits(m_visible_bits, visible_voxels);
+}
+
+/**
+ * Update the max-pooled foreground pyramid of each camera
+ */
+void Reconstructor::updateForegroundPyramids()
+{
+	int c;
+#pragma omp parallel for schedule(static) private(c)
+	for (c = 0; c < (int) m_cameras.size(); ++c)
+	{
+		vector<Mat> &pyramid = m_fg_pyramids[c];
+		pyramid[0] = Mat(m_plane_size, CV_8U, (void*) m_foregrounds[c]);
+		for (size_t l = 1; l < pyramid.size(); ++l)
+			maxPool(pyramid[l - 1], pyramid[l]);
+	}
+}
+
+/**
+ * Check if there's any white pixel in the box on camera c's foreground image, on the
+ * coarsest pyramid level that covers the box with at most 2x2 pixels (conservative)
+ */
+bool Reconstructor::hasForeground(
+		size_t c, const PixelBox &box) const
+{
+	const vector<Mat> &pyramid = m_fg_pyramids[c];
+	const int extent = std::max(box.x1 - box.x0, box.y1 - box.y0) + 1;
+
+	size_t l = 0;
+	while (l + 1 < pyramid.size() && (1 << l) < extent)
+		++l;
+
+	const Mat &level = pyramid[l];
+	for (int y = box.y0 >> l; y <= (box.y1 >> l); ++y)
+	{
+		const uchar* row = level.ptr(y);
+		for (int x = box.x0 >> l; x <= (box.x1 >> l); ++x)
+			if (row[x]) return true;
+	}
+
+	return false;
+}
+
+/**
+ * Carve octree node (x, y, z) of the given level: stop if any camera has no
+ * foreground in the node's pixel box, otherwise descend into its children,
+ * testing the voxels themselves at the bottom
+ */
+void Reconstructor::carveOctreeNode(
+		int level, int x, int y, int z)
+{
+	const size_t cameras_amount = m_cameras.size();
+	const Point3i &nodes = m_octree_dimensions[level];
+	const size_t nodes_amount = (size_t) nodes.x * nodes.y * nodes.z;
+	const size_t node = ((size_t) z * nodes.y + y) * nodes.x + x;
+
+	for (size_t c = 0; c < cameras_amount; ++c)
+	{
+		const PixelBox &box = m_octree_boxes[level][c * nodes_amount + node];
+		if (box.x0 > box.x1 || !hasForeground(c, box)) return;
+	}
+
+	const Point3i &children = m_octree_dimensions[level - 1];
+	for (int cz = 2 * z; cz < std::min(2 * z + 2, children.z); ++cz)
+		for (int cy = 2 * y; cy < std::min(2 * y + 2, children.y); ++cy)
+			for (int cx = 2 * x; cx < std::min(2 * x + 2, children.x); ++cx)
+			{
+				if (level > 1)
+				{
+					carveOctreeNode(level - 1, cx, cy, cz);
+					continue;
+				}
+
+				const int v = m_grid_index[(cz * children.y + cy) * children.x + cx];
+				if (v < 0) continue;
+
+				size_t camera_counter = 0;
+				for (; camera_counter < cameras_amount; ++camera_counter)
+				{
+					if (m_foregrounds[camera_counter][m_voxels.getOffsets(camera_counter)[v]] != 255) break;
+				}
+
+				if (camera_counter == cameras_amount)
+				{
+					// Other threads may write voxels sharing this word
+#pragma omp atomic
+					m_visible_bits[v / 64] |= (uint64_t) 1 << (v % 64);
+				}
+			}
+}
+
+/**
+ * Coarse-to-fine carving: only descend into voxel blocks that have foreground
+ * in their pixel box on every camera. Yields the same voxels as carveFlat.
+ */
+void Reconstructor::carveOctree(
+		std::vector<Voxel> &visible_voxels)
+{
+	updateForegroundPyramids();
+	std::fill(m_visible_bits.begin(), m_visible_bits.end(), 0);
+
+	const int top = (int) m_octree_dimensions.size() - 1;
+	const Point3i &nodes = m_octree_dimensions[top];
+
+	int n;
+#pragma omp parallel for schedule(dynamic) private(n)
+	for (n = 0; n < nodes.x * nodes.y * nodes.z; ++n)
+		carveOctreeNode(top, n % nodes.x, (n / nodes.x) % nodes.y, n / (nodes.x * nodes.y));
+
+	compactVisibleBits(m_visible_bits, visible_voxels);
+}
+
+/**
+ * Rebuild the incremental carving state from scratch: count the cameras that see
+ * foreground at each voxel's projection, flag the voxels all cameras see and keep
+ * a copy of the foregrounds the counts are based on
+ */
+void Reconstructor::resetIncremental()
+{
+	const size_t cameras_amount = m_cameras.size();
+	const size_t pixels = (size_t) m_plane_size.area();
+	const size_t words = m_incremental_bits.size();
+	assert(cameras_amount <= UCHAR_MAX);
+
+	m_voxel_counts.resize(m_voxels_amount);
+	m_previous_foregrounds.assign(cameras_amount, vector<uchar>());
+	for (size_t c = 0; c < cameras_amount; ++c)
+		m_previous_foregrounds[c].assign(m_foregrounds[c], m_foregrounds[c] + pixels);
+
+	int w;
+#pragma omp parallel for schedule(static) private(w)
+	for (w = 0; w < (int) words; ++w)
+	{
+		const size_t first = (size_t) w * 64;
+		const int last = (int) std::min<size_t>(64, m_voxels_amount - first);
+
+		uint64_t word = 0;
+		for (int b = 0; b < last; ++b)
 		{
-#pragma omp critical //push_back is critical
-			visible_voxels.push_back(voxel);
+			const size_t v = first + b;
+			uchar count = 0;
+			for (size_t c = 0; c < cameras_amount; ++c)
+				if (m_foregrounds[c][m_voxels.getOffsets(c)[v]] == 255) ++count;
+
+			m_voxel_counts[v] = count;
+			if (count == cameras_amount) word |= (uint64_t) 1 << b;
+		}
+		m_incremental_bits[w] = word;
+	}
+}
+
+/**
+ * Diff every camera's foreground against the one the incremental state is based on
+ * and only update the camera counters of the voxels that project on flipped pixels,
+ * so the cost scales with the motion in the scene rather than the volume size.
+ * Yields the same voxels as carveFlat.
+ */
+void Reconstructor::carveIncremental(
+		std::vector<Voxel> &visible_voxels)
+{
+	const size_t cameras_amount = m_cameras.size();
+	const size_t pixels = (size_t) m_plane_size.area();
+
+	if (m_previous_foregrounds.empty())
+	{
+		resetIncremental();
+		compactVisibleBits(m_incremental_bits, visible_voxels);
+		return;
+	}
+
+	for (size_t c = 0; c < cameras_amount; ++c)
+	{
+		const uchar* foreground = m_foregrounds[c];
+		uchar* previous = m_previous_foregrounds[c].data();
+		const int* starts = m_pixel_starts[c].data();
+		const int* voxels = m_pixel_voxels[c].data();
+
+		// Compare 8 pixels at a time. A voxel projects on exactly one pixel of a
+		// camera, so every voxel counter is updated by one thread only, but
+		// voxels sharing a bitset word may not.
+		const int chunks = (int) ((pixels + 7) / 8);
+		int chunk;
+#pragma omp parallel for schedule(static) private(chunk)
+		for (chunk = 0; chunk < chunks; ++chunk)
+		{
+			const size_t first = (size_t) chunk * 8;
+			const size_t last = std::min(pixels, first + 8);
+			if (last - first == 8)
+			{
+				uint64_t current_word, previous_word;
+				memcpy(&current_word, foreground + first, sizeof(current_word));
+				memcpy(&previous_word, previous + first, sizeof(previous_word));
+				if (current_word == previous_word) continue;
+			}
+
+			for (size_t p = first; p < last; ++p)
+			{
+				const bool on = foreground[p] == 255;
+				if (on == (previous[p] == 255)) continue;
+
+				for (int i = starts[p]; i < starts[p + 1]; ++i)
+				{
+					const int v = voxels[i];
+					const uint64_t bit = (uint64_t) 1 << (v % 64);
+					if (on)
+					{
+						if (++m_voxel_counts[v] == cameras_amount)
+						{
+#pragma omp atomic
+							m_incremental_bits[v / 64] |= bit;
+						}
+					}
+					else if (m_voxel_counts[v]-- == cameras_amount)
+					{
+#pragma omp atomic
+						m_incremental_bits[v / 64] &= ~bit;
+					}
+				}
+			}
+
+			memcpy(previous + first, foreground + first, last - first);
 		}
 	}
 
-	m_visible_voxels.insert(m_visible_voxels.end(), visible_voxels.begin(), visible_voxels.end());
+	compactVisibleBits(m_incremental_bits, visible_voxels);
+}
+
+/**
+ * Stable parallel compaction of the visible voxels bitset into visible_voxels:
+ * count the bits per block, prefix-sum the counts into output offsets and let
+ * every block write its own range. The output is in voxel index order and
+ * visible_voxels only reallocates when it outgrows its capacity.
+ */
+void Reconstructor::compactVisibleBits(
+		const std::vector<uint64_t> &visible_bits, std::vector<Voxel> &visible_voxels)
+{
+	const size_t words = visible_bits.size();
+	const int blocks = (int) m_block_offsets.size() - 1;
+
+	int b;
+#pragma omp parallel for schedule(static) private(b)
+	for (b = 0; b < blocks; ++b)
+	{
+		const size_t end = std::min(words, (b + 1) * COMPACTION_BLOCK_WORDS);
+		int count = 0;
+		for (size_t w = b * COMPACTION_BLOCK_WORDS; w < end; ++w)
+			count += General::popcount64(visible_bits[w]);
+		m_block_offsets[b + 1] = count;
+	}
+
+	m_block_offsets[0] = 0;
+	for (b = 0; b < blocks; ++b)
+		m_block_offsets[b + 1] += m_block_offsets[b];
+
+	visible_voxels.resize(m_block_offsets[blocks]);
+
+#pragma omp parallel for schedule(static) private(b)
+	for (b = 0; b < blocks; ++b)
+	{
+		const size_t end = std::min(words, (b + 1) * COMPACTION_BLOCK_WORDS);
+		Voxel* out = visible_voxels.data() + m_block_offsets[b];
+		for (size_t w = b * COMPACTION_BLOCK_WORDS; w < end; ++w)
+		{
+			for (uint64_t word = visible_bits[w]; word; word &= word - 1)
+				*out++ = m_voxels[(int) (w * 64 + General::ctz64(word))];
+		}
+	}
 }
 
 } /* namespace nl_uu_science_gmt */
@@ -10,9 +10,12 @@
 
 #include <opencv2/core/core.hpp>
 #include <stddef.h>
+#include <stdint.h>
+#include <string>
 #include <vector>
 
 #include "Camera.h"
+#include "VoxelStore.h"
 
 namespace nl_uu_science_gmt
 {
@@ -21,59 +24,169 @@ class Reconstructor
 {
 public:
 	/*
-	 * Voxel structure
-	 * Represents a 3D pixel in the half space
+	 * Voxel view
+	 * Represents a 3D pixel in the half space, backed by the VoxelStore
 	 */
-	struct Voxel
+	typedef VoxelStore::Voxel Voxel;
+
+	/*
+	 * Voxel carving engines, selectable at runtime
+	 */
+	enum CarvingMode
 	{
-		int x, y, z;                               // Coordinates
-		cv::Scalar color;                          // Color
-		std::vector<cv::Point> camera_projection;  // Projection location for camera[c]'s FoV (2D)
-		std::vector<int> valid_camera_projection;  // Flag if camera projection is in camera[c]'s FoV
+		CARVING_FLAT,                           // Test every voxel on the cameras one by one
+		CARVING_BITSET,                         // Per-camera occupancy bitsets, AND-reduced over the cameras
+		CARVING_OCTREE,                         // Coarse-to-fine: test voxel blocks before their voxels
+		CARVING_INCREMENTAL,                    // Re-test only the voxels on pixels whose foreground changed
+		CARVING_MODES                           // Amount of carving modes
+	};
+
+	/*
+	 * Voxel volume
+	 * Bounds and resolution of the carved space, and the memory it may take
+	 */
+	struct Volume
+	{
+		cv::Point3i min;                        // Lower bounds (mm)
+		cv::Point3i max;                        // Upper bounds (mm)
+		cv::Point3i step;                       // Step size per axis (space between voxels, mm)
+		double memory_budget;                   // Maximum voxel memory (MB), 0 for unlimited
+		bool downscale;                         // Coarsen the steps to fit the budget instead of refusing
+
+		Volume();
 	};
 
 private:
+	/*
+	 * Inclusive pixel bounds of the projections of a block of voxels on a camera,
+	 * empty if x0 > x1
+	 */
+	struct PixelBox
+	{
+		short x0, y0, x1, y1;
+	};
+
 	const std::vector<Camera*> &m_cameras;  // vector of pointers to cameras
-	const int m_height;                     // Cube half-space height from floor to ceiling
-	const int m_step;                       // Step size (space between voxels)
+	const Volume m_volume;                  // Volume bounds and step sizes
+	cv::Point3i m_dimensions;               // Voxel count per axis
 
-	std::vector<cv::Point3f*> m_corners;    // Cube half-space corner locations
+	std::vector<cv::Point3f*> m_corners;    // Volume corner locations
 
-	size_t m_voxels_amount;                 // Voxel count
+	size_t m_voxels_amount;                 // Voxel count (within the FoV of all cameras)
 	cv::Size m_plane_size;                  // Camera FoV plane WxH
 
-	std::vector<Voxel*> m_voxels;           // Pointer vector to all voxels in the half-space
-	std::vector<Voxel*> m_visible_voxels;   // Pointer vector to all visible voxels
+	VoxelStore m_voxels;                    // All voxels in the half-space within the FoV of all cameras
+	std::vector<int> m_grid_index;          // Store index of voxel grid cell (z * Y + y) * X + x, -1 if culled
+	std::vector<Voxel> m_visible_voxels;    // All visible voxels
+	size_t m_visible_version;               // Incremented whenever the visible voxels change
+
+	CarvingMode m_carving_mode;             // Active carving engine
+	double m_update_time;                   // Duration of the last update (ms)
+
+	std::vector<const uchar*> m_foregrounds;   // Foreground image data per camera (current frame)
+	std::vector<uint64_t> m_camera_bits;       // Occupancy bitset scratch of one camera (one bit per voxel)
+	std::vector<uint64_t> m_visible_bits;      // Occupancy bitset AND-reduced over the cameras
+	std::vector<int> m_block_offsets;          // Output offset per block of visible bits (compaction prefix sum)
+
+	std::vector<cv::Point3i> m_octree_dimensions;          // Node count per axis per octree level (level 0 = voxels)
+	std::vector<std::vector<PixelBox> > m_octree_boxes;    // Per level > 0: pixel box of node n on camera c at [c * nodes + n]
+	std::vector<std::vector<cv::Mat> > m_fg_pyramids;      // Per camera: max-pooled foreground pyramid (level 0 = foreground)
+
+	std::vector<std::vector<int> > m_pixel_starts;             // Per camera: start of pixel p's voxels in m_pixel_voxels (pixels + 1 entries)
+	std::vector<std::vector<int> > m_pixel_voxels;             // Per camera: voxel indices ordered by the pixel they project on
+	std::vector<uchar> m_voxel_counts;                         // Per voxel: amount of cameras with foreground at its projection
+	std::vector<uint64_t> m_incremental_bits;                  // Visible voxels bitset kept up to date by the incremental engine
+	std::vector<std::vector<uchar> > m_previous_foregrounds;   // Per camera: foreground the incremental state is based on
 
 	void initialize();
+	uint64_t getLutKey() const;
+	bool isLutInRange() const;
+	void initializeGridIndex();
+	void initializeOctree();
+	void initializeInverseLut();
+	void updateForegrounds();
+	void updateForegroundPyramids();
+	bool hasForeground(
+			size_t, const PixelBox &) const;
+	void carveOctreeNode(
+			int, int, int, int);
+
+	void carveFlat(
+			std::vector<Voxel> &);
+	void carveBitset(
+			std::vector<Voxel> &);
+	void carveOctree(
+			std::vector<Voxel> &);
+	void resetIncremental();
+	void carveIncremental(
+			std::vector<Voxel> &);
+	void carve(
+			CarvingMode, std::vector<Voxel> &);
+	void compactVisibleBits(
+			const std::vector<uint64_t> &, std::vector<Voxel> &);
 
 public:
 	Reconstructor(
-			const std::vector<Camera*> &);
+			const std::vector<Camera*> &, const Volume & = Volume());
 	virtual ~Reconstructor();
 
+	static bool readVolume(
+			const std::string &, Volume &);
+	static cv::Point3i getDimensions(
+			const Volume &);
+	static size_t estimateMemory(
+			const Volume &, size_t);
+	static bool fitVolume(
+			Volume &, const std::vector<Camera*> &);
+
 	void update();
+	double update(
+			const std::vector<const uchar*> &, std::vector<Voxel> &);
+	void extractSurface(
+			const std::vector<Voxel> &, std::vector<Voxel> &, std::vector<uint64_t> &) const;
+	void compareCarving();
+	void compareCarving(
+			const std::vector<const uchar*> &);
+
+	static const char* getCarvingModeName(
+			CarvingMode);
+
+	CarvingMode getCarvingMode() const
+	{
+		return m_carving_mode;
+	}
 
-	const std::vector<Voxel*>& getVisibleVoxels() const
+	void setCarvingMode(
+			CarvingMode carvingMode)
+	{
+		m_carving_mode = carvingMode;
+	}
+
+	double getUpdateTime() const
+	{
+		return m_update_time;
+	}
+
+	const std::vector<Voxel>& getVisibleVoxels() const
 	{
 		return m_visible_voxels;
 	}
 
-	const std::vector<Voxel*>& getVoxels() const
+	const VoxelStore& getVoxels() const
 	{
 		return m_voxels;
 	}
 
-	void setVisibleVoxels(
-			const std::vector<Voxel*>& visibleVoxels)
+	size_t getVisibleVersion() const
 	{
-		m_visible_voxels = visibleVoxels;
+		return m_visible_version;
 	}
 
-	void setVoxels(
-			const std::vector<Voxel*>& voxels)
+	void setVisibleVoxels(
+			const std::vector<Voxel>& visibleVoxels)
 	{
-		m_voxels = voxels;
+		m_visible_voxels = visibleVoxels;
+		++m_visible_version;
 	}
 
 	const std::vector<cv::Point3f*>& getCorners() const
@@ -81,9 +194,14 @@ public:
 		return m_corners;
 	}
 
-	int getSize() const
+	const Volume& getVolume() const
+	{
+		return m_volume;
+	}
+
+	const cv::Point3i& getDimensions() const
 	{
-		return m_height;
+		return m_dimensions;
 	}
 
 	const cv::Size& getPlaneSize() const
@@ -16,6 +16,7 @@
 #include <iostream>
 
 #include "../utilities/General.h"
+#include "../utilities/HsvSubtraction.h"
 
 using namespace std;
 using namespace cv;
@@ -32,7 +33,9 @@ Scene3DRenderer::Scene3DRenderer(
 				m_reconstructor(r),
 				m_cameras(cs),
 				m_num(4),
-				m_sphere_radius(1850)
+				m_sphere_radius(1850),
+				m_erosion(4),
+				m_dilation(5)
 {
 	m_width = 640;
 	m_height = 480;
@@ -41,6 +44,7 @@ Scene3DRenderer::Scene3DRenderer(
 	m_rotate = false;
 	m_camera_view = true;
 	m_show_volume = true;
+	m_show_cubes = false;
 	m_show_grd_flr = true;
 	m_show_cam = true;
 	m_show_org = true;
@@ -81,15 +85,33 @@ Scene3DRenderer::Scene3DRenderer(
 	updateS = false;
 	updateV = false;
 
+	createFloorGrid();
+	setTopView();
+}
 
-
+/**
+ * Create the frame and threshold sliders on the video window (interactive mode)
+ */
+void Scene3DRenderer::createTrackbars()
+{
 	createTrackbar("Frame", VIDEO_WINDOW, &m_current_frame, m_number_of_frames - 2);
 	createTrackbar("H", VIDEO_WINDOW, &m_h_threshold, 255);
 	createTrackbar("S", VIDEO_WINDOW, &m_s_threshold, 255);
 	createTrackbar("V", VIDEO_WINDOW, &m_v_threshold, 255);
+}
 
-	createFloorGrid();
-	setTopView();
+/**
+ * Use fixed background subtraction thresholds instead of determining them
+ */
+void Scene3DRenderer::setThresholds(
+		int h, int s, int v)
+{
+	m_h_threshold = m_ph_threshold = h;
+	m_s_threshold = m_ps_threshold = s;
+	m_v_threshold = m_pv_threshold = v;
+	updateH = false;
+	updateS = false;
+	updateV = false;
 }
 
 /**
@@ -105,10 +127,17 @@ Scene3DRenderer::~Scene3DRenderer()
 
 /**
  * Process the current frame on each camera
+ * Every camera decodes and segments its frame on its own worker of the OpenMP
+ * thread pool, the pool joins before returning. While the thresholds are being
+ * determined from camera 0 the cameras run one after another.
  */
 bool Scene3DRenderer::processFrame()
 {
-	for (size_t c = 0; c < m_cameras.size(); ++c)
+	const bool tuning = getUpdateH() || getUpdateS() || getUpdateV();
+
+	int c;
+#pragma omp parallel for schedule(dynamic) private(c) if (!tuning)
+	for (c = 0; c < (int) m_cameras.size(); ++c)
 	{
 		if (m_current_frame == m_previous_frame + 1)
 		{
@@ -125,34 +154,32 @@ bool Scene3DRenderer::processFrame()
 }
 
 /**
- * Separate the background from the foreground
- * ie.: Create an 8 bit image where only the foreground of the scene is white (255)
+ * Separate the background from the foreground of the camera's current frame,
+ * in the camera's persistent buffers, so no frame allocates
  */
 void Scene3DRenderer::processForeground(
 		Camera* camera, int cam_n)
 {
-	assert(!camera->getFrame().empty());
-	Mat hsv_image;
-	cvtColor(camera->getFrame(), hsv_image, CV_BGR2HSV);  // from BGR to HSV color space
-
-	vector<Mat> channels;
-	split(hsv_image, channels);  // Split the HSV-channels for further analysis
-
-
-	// Background subtraction H
-	Mat tmp, foreground, background;
-	absdiff(channels[0], camera->getBgHsvChannels().at(0), tmp);
-	threshold(tmp, foreground, m_h_threshold, 255, CV_THRESH_BINARY);
+	processForeground(camera, cam_n, getThresholds(), camera->getFrame(), camera->getMaskBuffer(),
+			camera->getMorphologyBuffer(), camera->getForegroundBuffer());
+}
 
-	// Background subtraction S
-	absdiff(channels[1], camera->getBgHsvChannels().at(1), tmp);
-	threshold(tmp, background, m_s_threshold, 255, CV_THRESH_BINARY);
-	bitwise_and(foreground, background, foreground);
+/**
+ * Separate the background from the foreground
+ * ie.: Create an 8 bit image where only the foreground of the scene is white (255)
+ * From the given video frame of the camera into output with the given
+ * thresholds, using the mask and morphology scratch buffers. Determining the
+ * thresholds changes them, which only the serial loop does.
+ */
+void Scene3DRenderer::processForeground(
+		Camera* camera, int cam_n, const Thresholds &thresholds, const Mat &frame, Mat &mask, Mat &morphology,
+		Mat &output)
+{
+	assert(!frame.empty());
 
-	// Background subtraction V
-	absdiff(channels[2], camera->getBgHsvChannels().at(2), tmp);
-	threshold(tmp, background, m_v_threshold, 255, CV_THRESH_BINARY);
-	bitwise_or(foreground, background, foreground);
+	// Background subtraction (H AND S) OR V, in HSV color space, in one pass
+	Mat &foreground = mask;
+	HsvSubtraction::apply(frame, camera->getBgHsvImage(), thresholds.h, thresholds.s, thresholds.v, foreground);
 
 	// Improve the foreground image
 	if (cam_n == 0) {
@@ -171,18 +198,30 @@ void Scene3DRenderer::processForeground(
 
 	if (!getUpdateH() && !getUpdateS() && !getUpdateV()) {
 		{
-			Mat kernel = getStructuringElement(MORPH_DILATE, Size(4, 4));
-			//morphologyEx(foreground, foreground, MORPH_DILATE, kernel);
-			erode(foreground, foreground, kernel);
-			kernel = getStructuringElement(MORPH_DILATE, Size(5, 5));
-			dilate(foreground, foreground, kernel);
+			m_erosion.erode(foreground, morphology);
+			m_dilation.dilate(morphology, output);
 		}
 	}
-
-	camera->setForegroundImage(foreground);
+	else
+	{
+		foreground.copyTo(output);
+	}
 
 }
 
+/**
+ * Put a video frame and its foreground image side by side in the canvas, which
+ * only reallocates when the frame size changes
+ */
+void Scene3DRenderer::createPreview(
+		const Mat &frame, const Mat &foreground, Mat &canvas)
+{
+	canvas.create(frame.rows, frame.cols + foreground.cols, CV_8UC3);
+	Mat frame_im = canvas(Rect(0, 0, frame.cols, frame.rows));
+	Mat fg_im_3c = canvas(Rect(frame.cols, 0, foreground.cols, foreground.rows));
+	frame.copyTo(frame_im);
+	cvtColor(foreground, fg_im_3c, CV_GRAY2BGR);
+}
 
 int Scene3DRenderer::compareMasks(cv::Mat foreground) {
 	Mat optimalImage = imread("C:\\Users\\Lorenzo\\Desktop\\University\\Computer Vision\\Code\\VoxelReconstruction\\VoxelReconstruction\\data\\ImageSubtraction.png");
@@ -313,28 +352,29 @@ void Scene3DRenderer::setTopView()
  */
 void Scene3DRenderer::createFloorGrid()
 {
-	const int size = m_reconstructor.getSize() / m_num;
+	const Reconstructor::Volume &volume = m_reconstructor.getVolume();
+	const int cells = 2 * m_num;
 	const int z_offset = 3;
 
 	// edge 1
 	vector<Point3i*> edge1;
-	for (int y = -size * m_num; y <= size * m_num; y += size)
-		edge1.push_back(new Point3i(-size * m_num, y, z_offset));
+	for (int g = 0; g <= cells; ++g)
+		edge1.push_back(new Point3i(volume.min.x, volume.min.y + (volume.max.y - volume.min.y) * g / cells, z_offset));
 
 	// edge 2
 	vector<Point3i*> edge2;
-	for (int x = -size * m_num; x <= size * m_num; x += size)
-		edge2.push_back(new Point3i(x, size * m_num, z_offset));
+	for (int g = 0; g <= cells; ++g)
+		edge2.push_back(new Point3i(volume.min.x + (volume.max.x - volume.min.x) * g / cells, volume.max.y, z_offset));
 
 	// edge 3
 	vector<Point3i*> edge3;
-	for (int y = -size * m_num; y <= size * m_num; y += size)
-		edge3.push_back(new Point3i(size * m_num, y, z_offset));
+	for (int g = 0; g <= cells; ++g)
+		edge3.push_back(new Point3i(volume.max.x, volume.min.y + (volume.max.y - volume.min.y) * g / cells, z_offset));
 
 	// edge 4
 	vector<Point3i*> edge4;
-	for (int x = -size * m_num; x <= size * m_num; x += size)
-		edge4.push_back(new Point3i(x, -size * m_num, z_offset));
+	for (int g = 0; g <= cells; ++g)
+		edge4.push_back(new Point3i(volume.min.x + (volume.max.x - volume.min.x) * g / cells, volume.min.y, z_offset));
 
 	m_floor_grid.push_back(edge1);
 	m_floor_grid.push_back(edge2);
@@ -20,12 +20,25 @@
 #include "arcball.h"
 #include "Camera.h"
 #include "Reconstructor.h"
+#include "../utilities/Morphology.h"
 
 namespace nl_uu_science_gmt
 {
 
 class Scene3DRenderer
 {
+public:
+	/*
+	 * Background subtraction thresholds, copied for every frame segmented off the GL thread
+	 */
+	struct Thresholds
+	{
+		int h;                                  // Hue threshold
+		int s;                                  // Saturation threshold
+		int v;                                  // Value threshold
+	};
+
+private:
 	Reconstructor &m_reconstructor;          // Reference to Reconstructor
 	const std::vector<Camera*> &m_cameras;  // Reference to camera's vector
 	const int m_num;                        // Floor grid scale
@@ -47,6 +60,7 @@ class Scene3DRenderer
 
 	bool m_camera_view;                       // flag if scene viewed from a camera
 	bool m_show_volume;                       // flag draw half-space edges
+	bool m_show_cubes;                        // flag draw voxels as cubes instead of points
 	bool m_show_grd_flr;                      // flag draw grid on floor
 	bool m_show_cam;                          // flag draw cameras into scene
 	bool m_show_org;                          // flag draw origin into scene
@@ -65,6 +79,9 @@ class Scene3DRenderer
 	int m_current_camera;                     // number of currently selected camera view point
 	int m_previous_camera;                    // number of previously selected camera view point
 
+	const Morphology m_erosion;               // Foreground erosion (4x4 cross)
+	const Morphology m_dilation;              // Foreground dilation (5x5 cross)
+
 	int m_h_threshold;                        // Hue threshold number for background subtraction
 	int m_ph_threshold;                       // Hue threshold value at previous iteration (update awareness)
 	int m_s_threshold;                        // Saturation threshold number for background subtraction
@@ -93,10 +110,18 @@ public:
 			Reconstructor &, const std::vector<Camera*> &);
 	virtual ~Scene3DRenderer();
 
+	void createTrackbars();
+	void setThresholds(
+			int, int, int);
+
 	void processForeground(
 			Camera*, int);
+	void processForeground(
+			Camera*, int, const Thresholds &, const cv::Mat &, cv::Mat &, cv::Mat &, cv::Mat &);
 
 	bool processFrame();
+	static void createPreview(
+			const cv::Mat &, const cv::Mat &, cv::Mat &);
 	int compareMasks(cv::Mat);
 	void detHThreshold(cv::Mat);
 	void detSThreshold(cv::Mat);
@@ -198,6 +223,17 @@ public:
 		m_show_volume = showVolume;
 	}
 
+	bool isShowCubes() const
+	{
+		return m_show_cubes;
+	}
+
+	void setShowCubes(
+			bool showCubes)
+	{
+		m_show_cubes = showCubes;
+	}
+
 	bool isShowFullscreen() const
 	{
 		return m_fullscreen;
@@ -365,6 +401,12 @@ public:
 		return m_v_threshold;
 	}
 
+	Thresholds getThresholds() const
+	{
+		const Thresholds thresholds = { m_h_threshold, m_s_threshold, m_v_threshold };
+		return thresholds;
+	}
+
 	int getPHThreshold() const
 	{
 		return m_ph_threshold;
@@ -0,0 +1,453 @@
+/*
+ * VoxelBuffer.cpp
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#define GL_GLEXT_PROTOTYPES
+#include "VoxelBuffer.h"
+
+#ifdef __linux__
+#include <GL/glext.h>
+#endif
+#include <stddef.h>
+#include <string.h>
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+
+using namespace std;
+
+namespace nl_uu_science_gmt
+{
+
+namespace
+{
+
+// Voxel color (gray, half transparent)
+const GLubyte VOXEL_COLOR[4] = { 128, 128, 128, 128 };
+
+#ifdef _WIN32
+// Vertex buffer objects are OpenGL 1.5, opengl32.dll exports 1.1: look them up in the driver
+#ifndef GL_ARRAY_BUFFER
+#define GL_ARRAY_BUFFER 0x8892
+#define GL_STREAM_DRAW 0x88E0
+#define GL_WRITE_ONLY 0x88B9
+#endif
+typedef ptrdiff_t GLsizeiptr;
+typedef void (APIENTRY *GenBuffersProc)(GLsizei, GLuint*);
+typedef void (APIENTRY *DeleteBuffersProc)(GLsizei, const GLuint*);
+typedef void (APIENTRY *BindBufferProc)(GLenum, GLuint);
+typedef void (APIENTRY *BufferDataProc)(GLenum, GLsizeiptr, const void*, GLenum);
+typedef void* (APIENTRY *MapBufferProc)(GLenum, GLenum);
+typedef GLboolean (APIENTRY *UnmapBufferProc)(GLenum);
+
+GenBuffersProc glGenBuffers = NULL;
+DeleteBuffersProc glDeleteBuffers = NULL;
+BindBufferProc glBindBuffer = NULL;
+BufferDataProc glBufferData = NULL;
+MapBufferProc glMapBuffer = NULL;
+UnmapBufferProc glUnmapBuffer = NULL;
+
+/*
+ * Look up the vertex buffer functions, false if the driver lacks any
+ */
+bool loadBufferFunctions()
+{
+	glGenBuffers = (GenBuffersProc) wglGetProcAddress("glGenBuffers");
+	glDeleteBuffers = (DeleteBuffersProc) wglGetProcAddress("glDeleteBuffers");
+	glBindBuffer = (BindBufferProc) wglGetProcAddress("glBindBuffer");
+	glBufferData = (BufferDataProc) wglGetProcAddress("glBufferData");
+	glMapBuffer = (MapBufferProc) wglGetProcAddress("glMapBuffer");
+	glUnmapBuffer = (UnmapBufferProc) wglGetProcAddress("glUnmapBuffer");
+	return glGenBuffers && glDeleteBuffers && glBindBuffer && glBufferData && glMapBuffer && glUnmapBuffer;
+}
+#else
+bool loadBufferFunctions()
+{
+	return true;
+}
+#endif
+
+#ifdef __linux__
+// Generic vertex attributes of the cube shader
+enum CubeAttribute
+{
+	ATTRIBUTE_CORNER,                      // Cube mesh vertex (per vertex)
+	ATTRIBUTE_NORMAL,                      // Cube mesh normal (per vertex)
+	ATTRIBUTE_OFFSET,                      // Voxel position (per instance)
+	ATTRIBUTE_COLOR                        // Voxel color (per instance)
+};
+
+// Cube mesh: the 3 faces on the positive side of each axis, 2 triangles each
+const int CUBE_VERTICES = 18;
+
+/*
+ * Vertex of the cube mesh
+ */
+struct CubeVertex
+{
+	GLfloat x, y, z;                     // Position on the unit cube around the origin
+	GLfloat nx, ny, nz;                  // Face normal
+};
+
+// At most 3 faces of a cube face the eye: mirror the mesh per axis to the eye's
+// side of the voxel, scale it to the voxel size and shade it with a headlight
+const char* CUBE_VERTEX_SHADER = "#version 120\n"
+		"attribute vec3 corner;\n"
+		"attribute vec3 normal;\n"
+		"attribute vec3 offset;\n"
+		"attribute vec4 color;\n"
+		"uniform vec3 size;\n"
+		"varying vec4 shade;\n"
+		"void main()\n"
+		"{\n"
+		"	vec3 eye = (gl_ModelViewMatrixInverse * vec4(0.0, 0.0, 0.0, 1.0)).xyz;\n"
+		"	vec3 side = step(offset, eye) * 2.0 - 1.0;\n"
+		"	vec3 n = normalize(gl_NormalMatrix * (normal * side));\n"
+		"	shade = vec4(color.rgb * (0.3 + 0.7 * abs(n.z)), 1.0);\n"
+		"	gl_Position = gl_ModelViewProjectionMatrix * vec4(offset + corner * side * size, 1.0);\n"
+		"}\n";
+
+const char* CUBE_FRAGMENT_SHADER = "#version 120\n"
+		"varying vec4 shade;\n"
+		"void main()\n"
+		"{\n"
+		"	gl_FragColor = shade;\n"
+		"}\n";
+
+typedef void (APIENTRY *VertexAttribDivisorProc)(GLuint, GLuint);
+typedef void (APIENTRY *DrawArraysInstancedProc)(GLenum, GLint, GLsizei, GLsizei);
+
+// Core (3.3) or ARB instancing entry points, whichever the context has
+VertexAttribDivisorProc vertexAttribDivisor = NULL;
+DrawArraysInstancedProc drawArraysInstanced = NULL;
+
+/*
+ * Check if the extension string of the context lists the given extension
+ */
+bool hasExtension(
+		const char* name)
+{
+	const char* extensions = (const char*) glGetString(GL_EXTENSIONS);
+	const size_t length = strlen(name);
+	for (const char* found = extensions; found != NULL && (found = strstr(found, name)) != NULL; found += length)
+	{
+		if ((found == extensions || found[-1] == ' ') && (found[length] == ' ' || found[length] == '\0'))
+			return true;
+	}
+	return false;
+}
+
+/*
+ * Pick the instancing functions for the given OpenGL version, false if it
+ * has neither the core functions nor the ARB extensions
+ */
+bool loadInstancingFunctions(
+		int major, int minor)
+{
+	if (major > 3 || (major == 3 && minor >= 3))
+	{
+		vertexAttribDivisor = glVertexAttribDivisor;
+		drawArraysInstanced = glDrawArraysInstanced;
+	}
+	else if ((major > 2 || (major == 2 && minor >= 1)) && hasExtension("GL_ARB_instanced_arrays")
+			&& hasExtension("GL_ARB_draw_instanced"))
+	{
+		vertexAttribDivisor = glVertexAttribDivisorARB;
+		drawArraysInstanced = glDrawArraysInstancedARB;
+	}
+	return vertexAttribDivisor != NULL && drawArraysInstanced != NULL;
+}
+
+/*
+ * Compile a shader, 0 (and the compile log on cerr) if it fails
+ */
+GLuint compileShader(
+		GLenum type, const char* source)
+{
+	const GLuint shader = glCreateShader(type);
+	glShaderSource(shader, 1, &source, NULL);
+	glCompileShader(shader);
+
+	GLint compiled = GL_FALSE;
+	glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+	if (!compiled)
+	{
+		char log[1024] = "";
+		glGetShaderInfoLog(shader, sizeof(log), NULL, log);
+		cerr << "Voxel cube shader does not compile: " << log << endl;
+		glDeleteShader(shader);
+		return 0;
+	}
+	return shader;
+}
+
+/*
+ * Fill the cube mesh: per axis the positive face, spanned by the other two axes
+ */
+void fillCube(
+		CubeVertex* vertices)
+{
+	const int corners[6] = { 0, 1, 2, 0, 2, 3 };   // Two triangles per face quad
+	const float quad[4][2] = { { -1, -1 }, { 1, -1 }, { 1, 1 }, { -1, 1 } };
+
+	CubeVertex* vertex = vertices;
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		const int u = (axis + 1) % 3;
+		const int v = (axis + 2) % 3;
+		for (int c = 0; c < 6; ++c, ++vertex)
+		{
+			GLfloat position[3], normal[3] = { 0, 0, 0 };
+			position[axis] = 0.5f;
+			position[u] = 0.5f * quad[corners[c]][0];
+			position[v] = 0.5f * quad[corners[c]][1];
+			normal[axis] = 1;
+
+			vertex->x = position[0];
+			vertex->y = position[1];
+			vertex->z = position[2];
+			vertex->nx = normal[0];
+			vertex->ny = normal[1];
+			vertex->nz = normal[2];
+		}
+	}
+}
+#endif
+
+/*
+ * Convert the voxels to vertices
+ */
+void fillVertices(
+		const vector<Reconstructor::Voxel> &voxels, VoxelBuffer::Vertex* vertices)
+{
+	for (size_t v = 0; v < voxels.size(); ++v)
+	{
+		VoxelBuffer::Vertex &vertex = vertices[v];
+		vertex.x = (GLfloat) voxels[v].x;
+		vertex.y = (GLfloat) voxels[v].y;
+		vertex.z = (GLfloat) voxels[v].z;
+		vertex.r = VOXEL_COLOR[0];
+		vertex.g = VOXEL_COLOR[1];
+		vertex.b = VOXEL_COLOR[2];
+		vertex.a = VOXEL_COLOR[3];
+	}
+}
+
+} /* namespace */
+
+VoxelBuffer::VoxelBuffer() :
+		m_buffer(0),
+		m_initialized(false),
+		m_capacity(0),
+		m_count(0),
+		m_version(0),
+		m_cube_buffer(0),
+		m_program(0),
+		m_size_location(-1),
+		m_cubes(false)
+{
+}
+
+VoxelBuffer::~VoxelBuffer()
+{
+	if (m_buffer != 0) glDeleteBuffers(1, &m_buffer);
+#ifdef __linux__
+	if (m_cube_buffer != 0) glDeleteBuffers(1, &m_cube_buffer);
+	if (m_program != 0) glDeleteProgram(m_program);
+#endif
+}
+
+/**
+ * Create the vertex buffer, if the OpenGL version has them (in the GL context)
+ */
+void VoxelBuffer::initialize()
+{
+	m_initialized = true;
+
+	const char* version = (const char*) glGetString(GL_VERSION);
+	int major = 0, minor = 0;
+	const bool has_buffers = version != NULL && sscanf(version, "%d.%d", &major, &minor) == 2
+			&& (major > 1 || minor >= 5) && loadBufferFunctions();
+	if (has_buffers) glGenBuffers(1, &m_buffer);
+#ifdef __linux__
+	if (has_buffers && loadInstancingFunctions(major, minor)) initializeCubes();
+#endif
+}
+
+/**
+ * Build the cube mesh buffer and the instanced cube shader program, both stay
+ * 0 if the shaders don't build
+ */
+void VoxelBuffer::initializeCubes()
+{
+#ifdef __linux__
+	const GLuint vertex_shader = compileShader(GL_VERTEX_SHADER, CUBE_VERTEX_SHADER);
+	const GLuint fragment_shader = compileShader(GL_FRAGMENT_SHADER, CUBE_FRAGMENT_SHADER);
+	if (vertex_shader == 0 || fragment_shader == 0)
+	{
+		if (vertex_shader != 0) glDeleteShader(vertex_shader);
+		if (fragment_shader != 0) glDeleteShader(fragment_shader);
+		return;
+	}
+
+	m_program = glCreateProgram();
+	glAttachShader(m_program, vertex_shader);
+	glAttachShader(m_program, fragment_shader);
+	glBindAttribLocation(m_program, ATTRIBUTE_CORNER, "corner");
+	glBindAttribLocation(m_program, ATTRIBUTE_NORMAL, "normal");
+	glBindAttribLocation(m_program, ATTRIBUTE_OFFSET, "offset");
+	glBindAttribLocation(m_program, ATTRIBUTE_COLOR, "color");
+	glLinkProgram(m_program);
+	glDeleteShader(vertex_shader);
+	glDeleteShader(fragment_shader);
+
+	GLint linked = GL_FALSE;
+	glGetProgramiv(m_program, GL_LINK_STATUS, &linked);
+	if (!linked)
+	{
+		char log[1024] = "";
+		glGetProgramInfoLog(m_program, sizeof(log), NULL, log);
+		cerr << "Voxel cube shader does not link: " << log << endl;
+		glDeleteProgram(m_program);
+		m_program = 0;
+		return;
+	}
+	m_size_location = glGetUniformLocation(m_program, "size");
+
+	CubeVertex cube[CUBE_VERTICES];
+	fillCube(cube);
+	glGenBuffers(1, &m_cube_buffer);
+	glBindBuffer(GL_ARRAY_BUFFER, m_cube_buffer);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(cube), cube, GL_STATIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+#endif
+}
+
+/**
+ * Upload the voxels of the given version: orphan the buffer and write the
+ * vertices into its mapped memory
+ */
+void VoxelBuffer::upload(
+		const vector<Reconstructor::Voxel> &voxels, size_t version)
+{
+	m_count = voxels.size();
+	m_version = version;
+
+	if (m_buffer == 0)
+	{
+		m_vertices.resize(m_count);
+		fillVertices(voxels, m_vertices.data());
+		return;
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
+	m_capacity = std::max(m_capacity, m_count);
+	glBufferData(GL_ARRAY_BUFFER, m_capacity * sizeof(Vertex), NULL, GL_STREAM_DRAW);
+	Vertex* vertices = m_count > 0 ? (Vertex*) glMapBuffer(GL_ARRAY_BUFFER, GL_WRITE_ONLY) : NULL;
+	if (vertices != NULL)
+	{
+		fillVertices(voxels, vertices);
+		if (!glUnmapBuffer(GL_ARRAY_BUFFER)) m_version = 0;  // Contents lost, upload again
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+/**
+ * Draw the given version of the visible voxels of the reconstructor, as points
+ * or as cubes on their surface, uploading them first if the version changed
+ * since the last draw
+ */
+void VoxelBuffer::draw(
+		const std::vector<Reconstructor::Voxel> &voxels, size_t version, const Reconstructor &reconstructor, bool cubes)
+{
+	if (!m_initialized) initialize();
+	cubes = cubes && m_program != 0;
+
+	if (version != m_version || cubes != m_cubes)
+	{
+		if (cubes)
+		{
+			reconstructor.extractSurface(voxels, m_surface, m_membership);
+			upload(m_surface, version);
+		}
+		else
+		{
+			upload(voxels, version);
+		}
+		m_cubes = cubes;
+	}
+	if (m_count == 0) return;
+
+	if (cubes)
+		drawCubes(reconstructor.getVolume().step);
+	else
+		drawPoints();
+}
+
+/**
+ * Draw the uploaded voxels as points
+ */
+void VoxelBuffer::drawPoints()
+{
+	const GLubyte* base = NULL;
+	if (m_buffer != 0)
+		glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
+	else
+		base = (const GLubyte*) m_vertices.data();
+
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_COLOR_ARRAY);
+	glVertexPointer(3, GL_FLOAT, sizeof(Vertex), base);
+	glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(Vertex), base + offsetof(Vertex, r));
+	glDrawArrays(GL_POINTS, 0, (GLsizei) m_count);
+	glDisableClientState(GL_COLOR_ARRAY);
+	glDisableClientState(GL_VERTEX_ARRAY);
+
+	if (m_buffer != 0) glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+/**
+ * Draw a cube of the given size (mm) at each uploaded voxel: the cube mesh
+ * per vertex, the voxel buffer per instance, in one call. Only the faces
+ * towards the eye are drawn, mirrored per voxel, so face culling is off.
+ */
+void VoxelBuffer::drawCubes(
+		const cv::Point3i &size)
+{
+#ifdef __linux__
+	glPushAttrib(GL_ENABLE_BIT);
+	glDisable(GL_CULL_FACE);
+	glUseProgram(m_program);
+	glUniform3f(m_size_location, (GLfloat) size.x, (GLfloat) size.y, (GLfloat) size.z);
+
+	glBindBuffer(GL_ARRAY_BUFFER, m_cube_buffer);
+	glEnableVertexAttribArray(ATTRIBUTE_CORNER);
+	glEnableVertexAttribArray(ATTRIBUTE_NORMAL);
+	glVertexAttribPointer(ATTRIBUTE_CORNER, 3, GL_FLOAT, GL_FALSE, sizeof(CubeVertex), (const void*) offsetof(CubeVertex, x));
+	glVertexAttribPointer(ATTRIBUTE_NORMAL, 3, GL_FLOAT, GL_FALSE, sizeof(CubeVertex), (const void*) offsetof(CubeVertex, nx));
+
+	glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
+	glEnableVertexAttribArray(ATTRIBUTE_OFFSET);
+	glEnableVertexAttribArray(ATTRIBUTE_COLOR);
+	glVertexAttribPointer(ATTRIBUTE_OFFSET, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const void*) offsetof(Vertex, x));
+	glVertexAttribPointer(ATTRIBUTE_COLOR, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Vertex), (const void*) offsetof(Vertex, r));
+	vertexAttribDivisor(ATTRIBUTE_OFFSET, 1);
+	vertexAttribDivisor(ATTRIBUTE_COLOR, 1);
+
+	drawArraysInstanced(GL_TRIANGLES, 0, CUBE_VERTICES, (GLsizei) m_count);
+
+	vertexAttribDivisor(ATTRIBUTE_OFFSET, 0);
+	vertexAttribDivisor(ATTRIBUTE_COLOR, 0);
+	glDisableVertexAttribArray(ATTRIBUTE_COLOR);
+	glDisableVertexAttribArray(ATTRIBUTE_OFFSET);
+	glDisableVertexAttribArray(ATTRIBUTE_NORMAL);
+	glDisableVertexAttribArray(ATTRIBUTE_CORNER);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glUseProgram(0);
+	glPopAttrib();
+#endif
+}
+
+} /* namespace nl_uu_science_gmt */
@@ -0,0 +1,83 @@
+/*
+ * VoxelBuffer.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#ifndef VOXELBUFFER_H_
+#define VOXELBUFFER_H_
+
+#ifdef _WIN32
+#include <Windows.h>
+#include <GL/gl.h>
+#endif
+#ifdef __linux__
+#include <GL/gl.h>
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include "Reconstructor.h"
+
+namespace nl_uu_science_gmt
+{
+
+/*
+ * Visible voxels as points in an OpenGL vertex buffer (positions + colors)
+ * The voxels are uploaded once per reconstructed frame, straight into the
+ * mapped buffer, and drawn with a single call. Redraws of the same frame
+ * only draw the buffer. Without vertex buffer objects (OpenGL < 1.5) the
+ * points are drawn from a client-side vertex array instead.
+ * In cube mode the same buffer holds one instance per surface voxel, and a
+ * single instanced call draws a shaded cube mesh at each of them (OpenGL 3.3,
+ * or 2.1 with ARB_instanced_arrays and ARB_draw_instanced; Linux only, else
+ * the voxels stay points).
+ */
+class VoxelBuffer
+{
+public:
+	/*
+	 * Vertex of one voxel
+	 */
+	struct Vertex
+	{
+		GLfloat x, y, z;                     // Position
+		GLubyte r, g, b, a;                  // Color
+	};
+
+private:
+	GLuint m_buffer;                         // Vertex buffer object, 0 if none (yet)
+	bool m_initialized;                      // Vertex buffer support was checked (needs a GL context)
+	size_t m_capacity;                       // Vertices the buffer holds
+	size_t m_count;                          // Vertices uploaded
+	size_t m_version;                        // Visible voxels version uploaded
+	std::vector<Vertex> m_vertices;          // Client-side vertex array (without vertex buffer objects)
+
+	GLuint m_cube_buffer;                    // Cube mesh (positions + normals), 0 without instancing
+	GLuint m_program;                        // Instanced cube shader program, 0 without instancing
+	GLint m_size_location;                   // Location of the cube size uniform
+	bool m_cubes;                            // Buffer holds cube instances (surface voxels)
+	std::vector<Reconstructor::Voxel> m_surface;  // Surface voxels scratch
+	std::vector<uint64_t> m_membership;      // Voxel membership bitset scratch of the surface extraction
+
+	void initialize();
+	void initializeCubes();
+	void upload(
+			const std::vector<Reconstructor::Voxel> &, size_t);
+	void drawPoints();
+	void drawCubes(
+			const cv::Point3i &);
+
+public:
+	VoxelBuffer();
+	virtual ~VoxelBuffer();
+
+	void draw(
+			const std::vector<Reconstructor::Voxel> &, size_t, const Reconstructor &, bool);
+};
+
+} /* namespace nl_uu_science_gmt */
+
+#endif /* VOXELBUFFER_H_ */
@@ -0,0 +1,183 @@
+/*
+ * VoxelStore.cpp
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#include "VoxelStore.h"
+
+#include <string.h>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+using namespace std;
+using namespace cv;
+
+namespace nl_uu_science_gmt
+{
+
+namespace
+{
+
+const char LUT_MAGIC[8] = { 'V', 'R', 'V', 'O', 'X', 'L', 'U', 'T' };
+const uint32_t LUT_VERSION = 1;
+
+/*
+ * LUT cache file header, followed by the x, y and z coordinate arrays and
+ * the camera-major pixel offset table (all int32)
+ */
+struct LutHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t header_size;
+	uint64_t key;                  // Hash of everything the LUT was computed from
+	uint64_t voxels;
+	uint32_t cameras;
+	int32_t plane_width;
+};
+
+} /* namespace */
+
+const int VoxelStore::OUTSIDE_FOV;
+
+VoxelStore::VoxelStore() :
+		m_size(0),
+		m_cameras_amount(0),
+		m_plane_width(0),
+		m_x_data(NULL),
+		m_y_data(NULL),
+		m_z_data(NULL),
+		m_offsets_data(NULL)
+{
+}
+
+VoxelStore::~VoxelStore()
+{
+}
+
+/**
+ * Acquire the memory for the given amount of voxels and cameras in one go,
+ * for cameras with FoV planes of the given width
+ */
+void VoxelStore::resize(
+		size_t voxels, size_t cameras, int plane_width)
+{
+	clear();
+
+	m_size = voxels;
+	m_cameras_amount = cameras;
+	m_plane_width = plane_width;
+
+	m_x.assign(voxels, 0);
+	m_y.assign(voxels, 0);
+	m_z.assign(voxels, 0);
+	m_offsets.assign(voxels * cameras, OUTSIDE_FOV);
+
+	m_x_data = m_x.data();
+	m_y_data = m_y.data();
+	m_z_data = m_z.data();
+	m_offsets_data = m_offsets.data();
+}
+
+/**
+ * Release all voxel memory
+ */
+void VoxelStore::clear()
+{
+	m_size = 0;
+	m_cameras_amount = 0;
+	m_plane_width = 0;
+
+	vector<int>().swap(m_x);
+	vector<int>().swap(m_y);
+	vector<int>().swap(m_z);
+	vector<int>().swap(m_offsets);
+	m_cache.close();
+
+	m_x_data = NULL;
+	m_y_data = NULL;
+	m_z_data = NULL;
+	m_offsets_data = NULL;
+}
+
+/**
+ * Write the voxels to a LUT cache file under the given key, written next to
+ * it first and renamed when complete, so a process that has the old file
+ * mapped keeps it intact and a crash never leaves a torn file
+ */
+bool VoxelStore::save(
+		const string &filename, uint64_t key) const
+{
+	const string partial = filename + ".partial";
+	ofstream file(partial.c_str(), ios::binary | ios::trunc);
+	if (!file.is_open()) return false;
+
+	LutHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, LUT_MAGIC, sizeof(LUT_MAGIC));
+	header.version = LUT_VERSION;
+	header.header_size = sizeof(LutHeader);
+	header.key = key;
+	header.voxels = m_size;
+	header.cameras = (uint32_t) m_cameras_amount;
+	header.plane_width = m_plane_width;
+
+	file.write((const char*) &header, sizeof(header));
+	file.write((const char*) m_x_data, m_size * sizeof(int));
+	file.write((const char*) m_y_data, m_size * sizeof(int));
+	file.write((const char*) m_z_data, m_size * sizeof(int));
+	file.write((const char*) m_offsets_data, m_size * m_cameras_amount * sizeof(int));
+	file.close();
+
+	if (!file.good())
+	{
+		remove(partial.c_str());
+		return false;
+	}
+
+	remove(filename.c_str());
+	return rename(partial.c_str(), filename.c_str()) == 0;
+}
+
+/**
+ * Map the voxels read-only from a LUT cache file, if it was written under the
+ * given key for the given amount of cameras and plane width
+ */
+bool VoxelStore::load(
+		const string &filename, uint64_t key, size_t cameras, int plane_width)
+{
+	clear();
+	if (!m_cache.open(filename)) return false;
+
+	LutHeader header;
+	bool valid = m_cache.size() >= sizeof(header);
+	if (valid)
+	{
+		memcpy(&header, m_cache.data(), sizeof(header));
+		valid = memcmp(header.magic, LUT_MAGIC, sizeof(LUT_MAGIC)) == 0 && header.version == LUT_VERSION
+				&& header.header_size == sizeof(LutHeader) && header.key == key && header.cameras == cameras
+				&& header.plane_width == plane_width
+				&& m_cache.size() == sizeof(header) + header.voxels * (3 + cameras) * sizeof(int);
+	}
+	if (!valid)
+	{
+		m_cache.close();
+		return false;
+	}
+
+	m_size = (size_t) header.voxels;
+	m_cameras_amount = cameras;
+	m_plane_width = plane_width;
+
+	const int* arrays = (const int*) (m_cache.data() + sizeof(header));
+	m_x_data = arrays;
+	m_y_data = arrays + m_size;
+	m_z_data = arrays + 2 * m_size;
+	m_offsets_data = arrays + 3 * m_size;
+
+	return true;
+}
+
+} /* namespace nl_uu_science_gmt */
@@ -0,0 +1,154 @@
+/*
+ * VoxelStore.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#ifndef VOXELSTORE_H_
+#define VOXELSTORE_H_
+
+#include <opencv2/core/core.hpp>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "../utilities/MappedFile.h"
+
+namespace nl_uu_science_gmt
+{
+
+/*
+ * Contiguous structure-of-arrays storage of the voxel space
+ * One coordinate array per axis plus a camera-major table of linear pixel
+ * offsets, so a voxel is an index rather than a heap object.
+ * The arrays are either owned or mapped read-only from a LUT cache file.
+ */
+class VoxelStore
+{
+public:
+	/*
+	 * Voxel view
+	 * Lightweight copy of a stored voxel's coordinates and its index in the store
+	 */
+	struct Voxel
+	{
+		int x, y, z;                               // Coordinates
+		int index;                                 // Index of the voxel in the store
+	};
+
+private:
+	size_t m_size;                             // Voxel count
+	size_t m_cameras_amount;                   // Camera count
+
+	std::vector<int> m_x;                      // X coordinate per voxel (when owned)
+	std::vector<int> m_y;                      // Y coordinate per voxel (when owned)
+	std::vector<int> m_z;                      // Z coordinate per voxel (when owned)
+
+	int m_plane_width;                         // Camera FoV plane width (pixels per row)
+
+	std::vector<int> m_offsets;                // Linear pixel offset on camera[c] of voxel v at [c * m_size + v] (when owned)
+
+	MappedFile m_cache;                        // Mapped LUT cache file (when not owned)
+
+	const int* m_x_data;                       // X coordinates, owned or mapped
+	const int* m_y_data;                       // Y coordinates, owned or mapped
+	const int* m_z_data;                       // Z coordinates, owned or mapped
+	const int* m_offsets_data;                 // Pixel offsets, owned or mapped
+
+public:
+	// Pixel offset of a voxel projection that falls outside a camera's FoV
+	static const int OUTSIDE_FOV = -1;
+
+	VoxelStore();
+	virtual ~VoxelStore();
+
+	void resize(
+			size_t, size_t, int);
+	void clear();
+
+	bool save(
+			const std::string &, uint64_t) const;
+	bool load(
+			const std::string &, uint64_t, size_t, int);
+
+	void setVoxel(
+			int v, int x, int y, int z)
+	{
+		m_x[v] = x;
+		m_y[v] = y;
+		m_z[v] = z;
+	}
+
+	/*
+	 * Store the projection of voxel v on camera c as a linear offset into
+	 * the (continuous) foreground image, or OUTSIDE_FOV
+	 */
+	void setOffset(
+			size_t c, int v, int offset)
+	{
+		m_offsets[c * m_size + v] = offset;
+	}
+
+	cv::Point getProjection(
+			size_t c, int v) const
+	{
+		const int offset = m_offsets_data[c * m_size + v];
+		return cv::Point(offset % m_plane_width, offset / m_plane_width);
+	}
+
+	Voxel operator[](
+			int v) const
+	{
+		Voxel voxel = { m_x_data[v], m_y_data[v], m_z_data[v], v };
+		return voxel;
+	}
+
+	size_t size() const
+	{
+		return m_size;
+	}
+
+	size_t getCamerasAmount() const
+	{
+		return m_cameras_amount;
+	}
+
+	bool isMapped() const
+	{
+		return m_cache.isOpen();
+	}
+
+	const int* getX() const
+	{
+		return m_x_data;
+	}
+
+	const int* getY() const
+	{
+		return m_y_data;
+	}
+
+	const int* getZ() const
+	{
+		return m_z_data;
+	}
+
+	int getPlaneWidth() const
+	{
+		return m_plane_width;
+	}
+
+	/*
+	 * The pixel offsets of all voxels on camera c (m_size entries)
+	 */
+	const int* getOffsets(
+			size_t c) const
+	{
+		return m_offsets_data + c * m_size;
+	}
+};
+
+} /* namespace nl_uu_science_gmt */
+
+#endif /* VOXELSTORE_H_ */
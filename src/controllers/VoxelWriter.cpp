@@ -0,0 +1,80 @@
+/*
+ * VoxelWriter.cpp
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#include "VoxelWriter.h"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+#include "../utilities/General.h"
+
+using namespace std;
+
+namespace nl_uu_science_gmt
+{
+
+/**
+ * Write into the given directory, or discard the voxels if it's empty
+ */
+VoxelWriter::VoxelWriter(
+		const string &directory) :
+				m_directory(directory),
+				m_frames(0),
+				m_voxels(0),
+				m_bytes(0)
+{
+}
+
+VoxelWriter::~VoxelWriter()
+{
+}
+
+/**
+ * Write the visible voxels of the given frame, false if the file can't be written
+ */
+bool VoxelWriter::write(
+		int frame_number, const vector<Reconstructor::Voxel> &voxels)
+{
+	++m_frames;
+	m_voxels += voxels.size();
+	if (m_directory.empty()) return true;
+
+	char name[32];
+	snprintf(name, sizeof(name), "voxels_%05d.ply", frame_number);
+	const string filename = m_directory + PATH_SEP + name;
+
+	stringstream header;
+	header << "ply" << endl;
+	header << "format binary_little_endian 1.0" << endl;
+	header << "comment frame " << frame_number << endl;
+	header << "element vertex " << voxels.size() << endl;
+	header << "property int x" << endl;
+	header << "property int y" << endl;
+	header << "property int z" << endl;
+	header << "end_header" << endl;
+
+	// Voxels carry their store index too: pack the coordinates (x86 is little endian)
+	m_coordinates.resize(voxels.size() * 3);
+	for (size_t v = 0; v < voxels.size(); ++v)
+	{
+		m_coordinates[3 * v] = voxels[v].x;
+		m_coordinates[3 * v + 1] = voxels[v].y;
+		m_coordinates[3 * v + 2] = voxels[v].z;
+	}
+
+	ofstream file(filename.c_str(), ios::binary | ios::trunc);
+	if (!file.is_open()) return false;
+	const string text = header.str();
+	file.write(text.data(), text.size());
+	file.write((const char*) m_coordinates.data(), m_coordinates.size() * sizeof(int32_t));
+	if (!file.good()) return false;
+
+	m_bytes += text.size() + m_coordinates.size() * sizeof(int32_t);
+	return true;
+}
+
+} /* namespace nl_uu_science_gmt */
@@ -0,0 +1,66 @@
+/*
+ * VoxelWriter.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#ifndef VOXELWRITER_H_
+#define VOXELWRITER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "Reconstructor.h"
+
+namespace nl_uu_science_gmt
+{
+
+/*
+ * Output sink of reconstructed frames
+ * Writes the visible voxels of every frame to <directory>/voxels_<frame>.ply,
+ * a binary point cloud with one vertex (int x, y, z in mm) per voxel that
+ * common point cloud tools read. Without a directory the voxels are only
+ * counted, to measure the reconstruction without the disk.
+ */
+class VoxelWriter
+{
+	const std::string m_directory;           // Output directory, empty to discard the voxels
+	std::vector<int32_t> m_coordinates;      // Write buffer: x, y, z per voxel
+	size_t m_frames;                         // Frames written
+	size_t m_voxels;                         // Voxels written
+	size_t m_bytes;                          // Bytes written
+
+public:
+	VoxelWriter(
+			const std::string & = "");
+	virtual ~VoxelWriter();
+
+	bool write(
+			int, const std::vector<Reconstructor::Voxel> &);
+
+	bool isDiscarding() const
+	{
+		return m_directory.empty();
+	}
+
+	size_t getFramesWritten() const
+	{
+		return m_frames;
+	}
+
+	size_t getVoxelsWritten() const
+	{
+		return m_voxels;
+	}
+
+	size_t getBytesWritten() const
+	{
+		return m_bytes;
+	}
+};
+
+} /* namespace nl_uu_science_gmt */
+
+#endif /* VOXELWRITER_H_ */
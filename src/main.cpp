@@ -1,4 +1,6 @@
 #include <cstdlib>
+#include <cstring>
+#include <iostream>
 #include <string>
 
 #include "utilities/General.h"
@@ -11,11 +13,36 @@ using namespace nl_uu_science_gmt;
 int main(
 		int argc, char** argv)
 {
+	// Data path and amount of cameras, the other options are read by VoxelReconstruction::run()
+	std::string data_path = "data" + std::string(PATH_SEP);
+	int cameras = 4;
+	bool headless = false;
+	for (int a = 1; a < argc; ++a)
+	{
+		if (strcmp(argv[a], "--data") == 0 && a + 1 < argc)
+		{
+			data_path = argv[++a];
+			if (data_path.empty() || data_path.compare(data_path.size() - 1, 1, PATH_SEP) != 0) data_path += PATH_SEP;
+		}
+		else if (strcmp(argv[a], "--cameras") == 0 && a + 1 < argc)
+		{
+			cameras = atoi(argv[++a]);
+		}
+		else if (strcmp(argv[a], "--headless") == 0)
+		{
+			headless = true;
+		}
+	}
+	if (cameras < 1)
+	{
+		std::cerr << "Need at least one camera" << std::endl;
+		return EXIT_FAILURE;
+	}
+
 	//runCalibration();
 	//blendImages();
-	VoxelReconstruction::showKeys();
-	VoxelReconstruction vr("data" + std::string(PATH_SEP), 4);
-	vr.run(argc, argv);
+	if (!headless) VoxelReconstruction::showKeys();
+	VoxelReconstruction vr(data_path, cameras);
 
-	return EXIT_SUCCESS;
+	return vr.run(argc, argv) ? EXIT_SUCCESS : EXIT_FAILURE;
 }
@@ -0,0 +1,69 @@
+/*
+ * AllocationCounter.cpp
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#include "AllocationCounter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+
+std::atomic<size_t> allocations(0);
+thread_local bool excluded = false;
+
+} /* namespace */
+
+#ifdef DEBUG
+void* operator new(
+		size_t size)
+{
+	if (!excluded) ++allocations;
+	void* memory = malloc(size ? size : 1);
+	if (memory == NULL) throw std::bad_alloc();
+	return memory;
+}
+
+void* operator new[](
+		size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(
+		void* memory) noexcept
+{
+	free(memory);
+}
+
+void operator delete[](
+		void* memory) noexcept
+{
+	free(memory);
+}
+#endif
+
+namespace nl_uu_science_gmt
+{
+
+/**
+ * Heap allocations since startup
+ */
+size_t AllocationCounter::getCount()
+{
+	return allocations.load();
+}
+
+/**
+ * Stop counting the allocations of the calling thread
+ */
+void AllocationCounter::excludeThread()
+{
+	excluded = true;
+}
+
+} /* namespace nl_uu_science_gmt */
@@ -0,0 +1,32 @@
+/*
+ * AllocationCounter.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#ifndef ALLOCATIONCOUNTER_H_
+#define ALLOCATIONCOUNTER_H_
+
+#include <stddef.h>
+
+namespace nl_uu_science_gmt
+{
+
+/*
+ * Debug counter of heap allocations
+ * In DEBUG builds the global operator new counts every allocation, which
+ * includes cv::Mat data (OpenCV 3 creates a UMatData block for every
+ * allocation). In other builds the count stays 0. Threads whose allocations
+ * happen outside the processing loop (the image codecs of the frame sources,
+ * the thread taking the pipeline's frames) can leave the count.
+ */
+class AllocationCounter
+{
+public:
+	static size_t getCount();
+	static void excludeThread();
+};
+
+} /* namespace nl_uu_science_gmt */
+
+#endif /* ALLOCATIONCOUNTER_H_ */
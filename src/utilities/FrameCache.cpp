@@ -0,0 +1,112 @@
+/*
+ * FrameCache.cpp
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#include "FrameCache.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+using namespace std;
+using namespace cv;
+
+namespace nl_uu_science_gmt
+{
+
+FrameCache::FrameCache() :
+		m_capacity(0),
+		m_clock(0),
+		m_cursor(0),
+		m_hits(0),
+		m_misses(0)
+{
+}
+
+/**
+ * Allocate room for the given amount of frames of the given size and type,
+ * 0 disables the cache
+ */
+void FrameCache::setCapacity(
+		size_t frames, const Size &size, int type)
+{
+	m_capacity = frames;
+	m_entries.resize(frames);
+	for (size_t e = 0; e < frames; ++e)
+	{
+		m_entries[e].number = -1;
+		m_entries[e].last_use = 0;
+		m_entries[e].image.create(size, type);
+	}
+}
+
+/**
+ * The cached frame with the given number, NULL if it isn't cached
+ * (a linear scan: no index to maintain and the cache holds at most a few hundred frames)
+ */
+FrameCache::Entry* FrameCache::find(
+		int number)
+{
+	for (size_t e = 0; e < m_entries.size(); ++e)
+		if (m_entries[e].number == number) return &m_entries[e];
+	return NULL;
+}
+
+/**
+ * Copy the frame with the given number into image if it's cached,
+ * and move the cursor to it
+ */
+bool FrameCache::get(
+		int number, Mat &image)
+{
+	m_cursor = number;
+
+	Entry* entry = find(number);
+	if (entry == NULL)
+	{
+		++m_misses;
+		return false;
+	}
+
+	++m_hits;
+	entry->last_use = ++m_clock;
+	entry->image.copyTo(image);
+	return true;
+}
+
+/**
+ * Cache a copy of the frame with the given number. When the cache is full it
+ * replaces the least recently used frame outside the window around the cursor,
+ * or the frame farthest from the cursor if they're all inside.
+ */
+void FrameCache::put(
+		int number, const Mat &image)
+{
+	if (m_capacity == 0) return;
+
+	Entry* entry = find(number);
+	if (entry == NULL) entry = find(-1);
+	if (entry == NULL)
+	{
+		// The window covers half of the cache, centered on the cursor
+		const int window = (int) std::max<size_t>(1, m_capacity / 4);
+
+		Entry* lru = NULL;
+		Entry* farthest = &m_entries.front();
+		for (size_t e = 0; e < m_entries.size(); ++e)
+		{
+			Entry &candidate = m_entries[e];
+			const int distance = abs(candidate.number - m_cursor);
+			if (distance > window && (lru == NULL || candidate.last_use < lru->last_use)) lru = &candidate;
+			if (distance > abs(farthest->number - m_cursor)) farthest = &candidate;
+		}
+		entry = lru != NULL ? lru : farthest;
+	}
+
+	entry->number = number;
+	entry->last_use = ++m_clock;
+	image.copyTo(entry->image);
+}
+
+} /* namespace nl_uu_science_gmt */
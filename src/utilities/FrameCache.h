@@ -0,0 +1,75 @@
+/*
+ * FrameCache.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#ifndef FRAMECACHE_H_
+#define FRAMECACHE_H_
+
+#include <opencv2/core/core.hpp>
+#include <stddef.h>
+#include <vector>
+
+namespace nl_uu_science_gmt
+{
+
+/*
+ * Cache of decoded video frames of one camera
+ * Holds up to a fixed amount of frames. When full, the least recently used
+ * frame outside a window around the last requested frame (the cursor) makes
+ * room, so stepping back and scrubbing near the cursor stay cached. All frame
+ * buffers are allocated up front and reused.
+ */
+class FrameCache
+{
+	/*
+	 * Cached frame
+	 */
+	struct Entry
+	{
+		int number;                          // Video frame number, -1 if unused
+		size_t last_use;                     // Value of m_clock at the last get or put
+		cv::Mat image;                       // Decoded frame
+	};
+
+	std::vector<Entry> m_entries;            // Cached frames
+	size_t m_capacity;                       // Maximum amount of cached frames
+	size_t m_clock;                          // Use counter (LRU order)
+	int m_cursor;                            // Last requested frame number
+
+	size_t m_hits;                           // Frames served from the cache
+	size_t m_misses;                         // Frames that had to be decoded
+
+	Entry* find(
+			int);
+
+public:
+	FrameCache();
+
+	void setCapacity(
+			size_t, const cv::Size &, int);
+	bool get(
+			int, cv::Mat &);
+	void put(
+			int, const cv::Mat &);
+
+	size_t getCapacity() const
+	{
+		return m_capacity;
+	}
+
+	size_t getHits() const
+	{
+		return m_hits;
+	}
+
+	size_t getMisses() const
+	{
+		return m_misses;
+	}
+};
+
+} /* namespace nl_uu_science_gmt */
+
+#endif /* FRAMECACHE_H_ */
@@ -0,0 +1,49 @@
+/*
+ * FrameSource.cpp
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#include "FrameSource.h"
+
+using namespace std;
+using namespace cv;
+
+namespace nl_uu_science_gmt
+{
+
+FrameSource::FrameSource() :
+		m_frames_read(0),
+		m_read_ticks(0),
+		m_position(0)
+{
+}
+
+FrameSource::~FrameSource()
+{
+}
+
+/**
+ * Read the frame with the given number into the given image, seeking only if
+ * the source isn't at that frame already
+ */
+bool FrameSource::read(
+		int frame_number, Mat &frame)
+{
+	const int64_t start = getTickCount();
+	const bool read = (frame_number == m_position || seek(frame_number)) && grab() && retrieve(frame);
+	m_read_ticks += getTickCount() - start;
+
+	if (read) ++m_frames_read;
+	return read;
+}
+
+/**
+ * Frames read per second of reading
+ */
+double FrameSource::getThroughput() const
+{
+	return m_read_ticks > 0 ? m_frames_read * getTickFrequency() / m_read_ticks : 0;
+}
+
+} /* namespace nl_uu_science_gmt */
@@ -0,0 +1,74 @@
+/*
+ * FrameSource.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#ifndef FRAMESOURCE_H_
+#define FRAMESOURCE_H_
+
+#include <opencv2/core/core.hpp>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace nl_uu_science_gmt
+{
+
+/*
+ * Where a camera's frames come from
+ * Frames are numbered from 0. grab() moves on to the frame at the current
+ * position (decoding as little as possible), retrieve() hands out the frame
+ * grabbed last and seek() sets the position. Every source times its own reads,
+ * so the sources can be compared on the same sequence.
+ */
+class FrameSource
+{
+	size_t m_frames_read;                    // Frames read with read()
+	int64_t m_read_ticks;                    // Time spent in read() (ticks)
+
+protected:
+	int m_position;                          // Frame number the next grab moves on to
+
+public:
+	FrameSource();
+	virtual ~FrameSource();
+
+	virtual bool grab() = 0;
+	virtual bool retrieve(
+			cv::Mat &) = 0;
+	virtual bool seek(
+			int) = 0;
+
+	virtual size_t getFrameAmount() const = 0;
+	virtual cv::Size getSize() const = 0;
+	virtual double getTimestamp(
+			int) const = 0;
+	virtual const char* getName() const = 0;
+
+	/*
+	 * True if retrieve() points the image at memory owned by the source (read-only)
+	 * instead of writing into the image's buffer
+	 */
+	virtual bool isZeroCopy() const
+	{
+		return false;
+	}
+
+	bool read(
+			int, cv::Mat &);
+	double getThroughput() const;
+
+	int getPosition() const
+	{
+		return m_position;
+	}
+
+	size_t getFramesRead() const
+	{
+		return m_frames_read;
+	}
+};
+
+} /* namespace nl_uu_science_gmt */
+
+#endif /* FRAMESOURCE_H_ */
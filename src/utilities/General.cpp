@@ -7,6 +7,7 @@
 
 #include "General.h"
 
+#include <sys/stat.h>
 #include <fstream>
 
 using namespace std;
@@ -19,9 +20,14 @@ const string General::CalibrationVideo     = "calibration.avi";
 const string General::CheckerboadVideo     = "checkerboard.avi";
 const string General::BackgroundImageFile  = "background.png";
 const string General::VideoFile            = "video.avi";
+const string General::VideoIndexFile       = "video.idx";
+const string General::RawFramesFile        = "video.raw";
+const string General::ImageSequencePattern = "frames" PATH_SEP "%05d.png";
 const string General::IntrinsicsFile       = "intrinsics.xml";
 const string General::CheckerboardCorners   = "boardcorners.xml";
 const string General::ConfigFile           = "config.xml";
+const string General::VolumeConfigFile     = "volume.xml";
+const string General::VoxelCacheFile       = "voxels.lut";
 
 /**
  * Linux/Windows friendly way to check if a file exists
@@ -32,4 +38,44 @@ bool General::fexists(const std::string &filename)
 	return ifile.is_open();
 }
 
+/**
+ * Size and modification time of a file, to tell whether a file derived from it
+ * is still up to date; false if it doesn't exist
+ */
+bool General::fileStamp(const std::string &filename, uint64_t &size, int64_t &mtime)
+{
+	struct stat st;
+	if (stat(filename.c_str(), &st) != 0) return false;
+	size = (uint64_t) st.st_size;
+	mtime = (int64_t) st.st_mtime;
+	return true;
+}
+
+/**
+ * Check (once) whether the CPU and OS support AVX2
+ */
+bool General::hasAVX2()
+{
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+	static const bool has_avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+	return has_avx2;
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+	static bool has_avx2 = false;
+	static bool checked = false;
+	if (!checked)
+	{
+		int info[4];
+		__cpuid(info, 1);
+		const bool os_avx = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6;
+		const bool fma = (info[2] & (1 << 12)) != 0;
+		__cpuidex(info, 7, 0);
+		has_avx2 = os_avx && fma && (info[1] & (1 << 5));
+		checked = true;
+	}
+	return has_avx2;
+#else
+	return false;
+#endif
+}
+
 } /* namespace nl_uu_science_gmt */
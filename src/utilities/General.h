@@ -10,10 +10,28 @@
 
 #include <opencv2/core/core.hpp>
 #include <opencv2/core/operations.hpp>
+#include <stdint.h>
 #include <string>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
 
 #define PATH_SEP "/"
 
+// Compile a single function for AVX2 (+FMA), call it only if General::hasAVX2()
+#if defined(__GNUC__)
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#define TARGET_AVX2_FMA __attribute__((target("avx2,fma")))
+#else
+#define TARGET_AVX2
+#define TARGET_AVX2_FMA
+#endif
+
+// x86 SIMD intrinsics are available
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define HAVE_X86_SIMD
+#endif
+
 namespace nl_uu_science_gmt
 {
 
@@ -41,10 +59,50 @@ public:
 	static const std::string CheckerboadVideo;
 	static const std::string CheckerboardCorners;
 	static const std::string VideoFile;
+	static const std::string VideoIndexFile;
+	static const std::string RawFramesFile;
+	static const std::string ImageSequencePattern;
 	static const std::string BackgroundImageFile;
 	static const std::string ConfigFile;
+	static const std::string VolumeConfigFile;
+	static const std::string VoxelCacheFile;
 
 	static bool fexists(const std::string &);
+	static bool fileStamp(const std::string &, uint64_t &, int64_t &);
+	static bool hasAVX2();
+
+	/*
+	 * Index of the lowest set bit (bits must be non-zero)
+	 */
+	static inline int ctz64(uint64_t bits)
+	{
+#if defined(_MSC_VER) && defined(_M_X64)
+		unsigned long index;
+		_BitScanForward64(&index, bits);
+		return (int) index;
+#elif defined(_MSC_VER)
+		unsigned long index;
+		if (_BitScanForward(&index, (unsigned long) bits)) return (int) index;
+		_BitScanForward(&index, (unsigned long) (bits >> 32));
+		return (int) index + 32;
+#else
+		return __builtin_ctzll(bits);
+#endif
+	}
+
+	/*
+	 * Amount of set bits
+	 */
+	static inline int popcount64(uint64_t bits)
+	{
+#if defined(_MSC_VER) && defined(_M_X64)
+		return (int) __popcnt64(bits);
+#elif defined(_MSC_VER)
+		return (int) (__popcnt((unsigned int) bits) + __popcnt((unsigned int) (bits >> 32)));
+#else
+		return __builtin_popcountll(bits);
+#endif
+	}
 };
 
 } /* namespace nl_uu_science_gmt */
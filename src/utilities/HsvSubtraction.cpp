@@ -0,0 +1,185 @@
+/*
+ * HsvSubtraction.cpp
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#include "HsvSubtraction.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+
+#include "General.h"
+
+#ifdef HAVE_X86_SIMD
+#include <immintrin.h>
+#endif
+
+using namespace std;
+using namespace cv;
+
+namespace nl_uu_science_gmt
+{
+
+namespace
+{
+
+// Fixed point precision of the BGR to HSV conversion (as in cvtColor)
+const int HSV_SHIFT = 12;
+
+// 8-bit hue range (as in cvtColor with CV_BGR2HSV)
+const int HUE_RANGE = 180;
+
+/*
+ * Reciprocal tables of the BGR to HSV conversion (as in cvtColor)
+ */
+struct HsvTables
+{
+	int sdiv[256];                 // (255 << HSV_SHIFT) / V
+	int hdiv[256];                 // (HUE_RANGE << HSV_SHIFT) / (6 * (V - min(B, G, R)))
+
+	HsvTables()
+	{
+		sdiv[0] = hdiv[0] = 0;
+		for (int i = 1; i < 256; ++i)
+		{
+			sdiv[i] = cvRound((255 << HSV_SHIFT) / (1. * i));
+			hdiv[i] = cvRound((HUE_RANGE << HSV_SHIFT) / (6. * i));
+		}
+	}
+};
+
+const HsvTables TABLES;
+
+/*
+ * Subtract pixels [x, width) of a row, the reference for the vectorized kernel
+ */
+void subtractRow(
+		const uchar* bgr, const uchar* bg_hsv, uchar* mask, int x, int width, int h_threshold, int s_threshold, int v_threshold)
+{
+	for (; x < width; ++x)
+	{
+		const int b = bgr[3 * x], g = bgr[3 * x + 1], r = bgr[3 * x + 2];
+
+		const int v = std::max(std::max(b, g), r);
+		const int diff = v - std::min(std::min(b, g), r);
+		const int vr = v == r ? -1 : 0;
+		const int vg = v == g ? -1 : 0;
+
+		const int s = (diff * TABLES.sdiv[v] + (1 << (HSV_SHIFT - 1))) >> HSV_SHIFT;
+		int h = (vr & (g - b)) + (~vr & ((vg & (b - r + 2 * diff)) + (~vg & (r - g + 4 * diff))));
+		h = (h * TABLES.hdiv[diff] + (1 << (HSV_SHIFT - 1))) >> HSV_SHIFT;
+		h += h < 0 ? HUE_RANGE : 0;
+
+		const bool foreground = (abs(h - bg_hsv[3 * x]) > h_threshold && abs(s - bg_hsv[3 * x + 1]) > s_threshold)
+				|| abs(v - bg_hsv[3 * x + 2]) > v_threshold;
+		mask[x] = foreground ? 255 : 0;
+	}
+}
+
+#ifdef HAVE_X86_SIMD
+/*
+ * Split 8 interleaved 3-channel pixels into one 32-bit lane per pixel per channel
+ */
+TARGET_AVX2 inline void deinterleave(
+		const uchar* pixels, __m256i &c0, __m256i &c1, __m256i &c2)
+{
+	const __m128i lo = _mm_loadu_si128((const __m128i*) pixels);          // bytes 0..15
+	const __m128i hi = _mm_loadl_epi64((const __m128i*) (pixels + 16));   // bytes 16..23
+
+	c0 = _mm256_cvtepu8_epi32(
+			_mm_or_si128(_mm_shuffle_epi8(lo, _mm_setr_epi8(0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)),
+					_mm_shuffle_epi8(hi, _mm_setr_epi8(-1, -1, -1, -1, -1, -1, 2, 5, -1, -1, -1, -1, -1, -1, -1, -1))));
+	c1 = _mm256_cvtepu8_epi32(
+			_mm_or_si128(_mm_shuffle_epi8(lo, _mm_setr_epi8(1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)),
+					_mm_shuffle_epi8(hi, _mm_setr_epi8(-1, -1, -1, -1, -1, 0, 3, 6, -1, -1, -1, -1, -1, -1, -1, -1))));
+	c2 = _mm256_cvtepu8_epi32(
+			_mm_or_si128(_mm_shuffle_epi8(lo, _mm_setr_epi8(2, 5, 8, 11, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)),
+					_mm_shuffle_epi8(hi, _mm_setr_epi8(-1, -1, -1, -1, -1, 1, 4, 7, -1, -1, -1, -1, -1, -1, -1, -1))));
+}
+
+/*
+ * Subtract a row 8 pixels per instruction, returns the first pixel left for subtractRow
+ */
+TARGET_AVX2 int subtractRowAVX2(
+		const uchar* bgr, const uchar* bg_hsv, uchar* mask, int width, int h_threshold, int s_threshold, int v_threshold)
+{
+	const __m256i half = _mm256_set1_epi32(1 << (HSV_SHIFT - 1));
+	const __m256i hue_range = _mm256_set1_epi32(HUE_RANGE);
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i h_thr = _mm256_set1_epi32(h_threshold);
+	const __m256i s_thr = _mm256_set1_epi32(s_threshold);
+	const __m256i v_thr = _mm256_set1_epi32(v_threshold);
+
+	int x = 0;
+	for (; x + 8 <= width; x += 8)
+	{
+		__m256i b, g, r, bg_h, bg_s, bg_v;
+		deinterleave(bgr + 3 * x, b, g, r);
+		deinterleave(bg_hsv + 3 * x, bg_h, bg_s, bg_v);
+
+		const __m256i v = _mm256_max_epi32(_mm256_max_epi32(b, g), r);
+		const __m256i diff = _mm256_sub_epi32(v, _mm256_min_epi32(_mm256_min_epi32(b, g), r));
+		const __m256i vr = _mm256_cmpeq_epi32(v, r);
+		const __m256i vg = _mm256_cmpeq_epi32(v, g);
+
+		const __m256i sdiv = _mm256_i32gather_epi32(TABLES.sdiv, v, 4);
+		const __m256i s = _mm256_srai_epi32(_mm256_add_epi32(_mm256_mullo_epi32(diff, sdiv), half), HSV_SHIFT);
+
+		const __m256i h_r = _mm256_sub_epi32(g, b);
+		const __m256i h_g = _mm256_add_epi32(_mm256_sub_epi32(b, r), _mm256_slli_epi32(diff, 1));
+		const __m256i h_b = _mm256_add_epi32(_mm256_sub_epi32(r, g), _mm256_slli_epi32(diff, 2));
+		__m256i h = _mm256_blendv_epi8(_mm256_blendv_epi8(h_b, h_g, vg), h_r, vr);
+		const __m256i hdiv = _mm256_i32gather_epi32(TABLES.hdiv, diff, 4);
+		h = _mm256_srai_epi32(_mm256_add_epi32(_mm256_mullo_epi32(h, hdiv), half), HSV_SHIFT);
+		h = _mm256_add_epi32(h, _mm256_and_si256(_mm256_cmpgt_epi32(zero, h), hue_range));
+
+		const __m256i h_fg = _mm256_cmpgt_epi32(_mm256_abs_epi32(_mm256_sub_epi32(h, bg_h)), h_thr);
+		const __m256i s_fg = _mm256_cmpgt_epi32(_mm256_abs_epi32(_mm256_sub_epi32(s, bg_s)), s_thr);
+		const __m256i v_fg = _mm256_cmpgt_epi32(_mm256_abs_epi32(_mm256_sub_epi32(v, bg_v)), v_thr);
+		const __m256i fg = _mm256_or_si256(_mm256_and_si256(h_fg, s_fg), v_fg);
+
+		// -1 / 0 lanes to 255 / 0 bytes
+		const __m128i fg16 = _mm_packs_epi32(_mm256_castsi256_si128(fg), _mm256_extracti128_si256(fg, 1));
+		_mm_storel_epi64((__m128i*) (mask + x), _mm_packs_epi16(fg16, fg16));
+	}
+
+	return x;
+}
+#endif
+
+} /* namespace */
+
+/**
+ * Write the foreground mask of a BGR frame against an (interleaved) HSV background
+ * image, with the given H, S and V thresholds (a difference above the threshold
+ * is foreground, as with cv::threshold and CV_THRESH_BINARY)
+ */
+void HsvSubtraction::apply(
+		const Mat &frame, const Mat &bg_hsv, int h_threshold, int s_threshold, int v_threshold, Mat &mask)
+{
+	assert(frame.type() == CV_8UC3 && bg_hsv.type() == CV_8UC3 && frame.size() == bg_hsv.size());
+	mask.create(frame.size(), CV_8U);
+
+#ifdef HAVE_X86_SIMD
+	const bool avx2 = General::hasAVX2();
+#endif
+
+	int y;
+#pragma omp parallel for schedule(static) private(y)
+	for (y = 0; y < frame.rows; ++y)
+	{
+		const uchar* bgr = frame.ptr(y);
+		const uchar* bg = bg_hsv.ptr(y);
+		uchar* out = mask.ptr(y);
+
+		int x = 0;
+#ifdef HAVE_X86_SIMD
+		if (avx2) x = subtractRowAVX2(bgr, bg, out, frame.cols, h_threshold, s_threshold, v_threshold);
+#endif
+		subtractRow(bgr, bg, out, x, frame.cols, h_threshold, s_threshold, v_threshold);
+	}
+}
+
+} /* namespace nl_uu_science_gmt */
@@ -0,0 +1,231 @@
+/*
+ * ImageSequenceSource.cpp
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#include "ImageSequenceSource.h"
+
+#include <opencv2/highgui/highgui.hpp>
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+
+#include "AllocationCounter.h"
+#include "General.h"
+
+using namespace std;
+using namespace cv;
+
+namespace nl_uu_science_gmt
+{
+
+namespace
+{
+
+/*
+ * Wait a moment for a decode
+ */
+void backoff()
+{
+	this_thread::sleep_for(chrono::milliseconds(1));
+}
+
+/*
+ * Read a whole file into the given buffer (reusing its capacity)
+ */
+bool readFile(
+		const char* filename, vector<uchar> &data)
+{
+	FILE* file = fopen(filename, "rb");
+	if (file == NULL) return false;
+
+	bool read = fseek(file, 0, SEEK_END) == 0;
+	const long length = read ? ftell(file) : -1;
+	read = length > 0 && fseek(file, 0, SEEK_SET) == 0;
+	if (read)
+	{
+		data.resize((size_t) length);
+		read = fread(&data[0], 1, data.size(), file) == data.size();
+	}
+	fclose(file);
+
+	return read;
+}
+
+} /* namespace */
+
+const int ImageSequenceSource::AHEAD;
+const int ImageSequenceSource::WORKERS;
+
+ImageSequenceSource::ImageSequenceSource(
+		double fps) :
+				m_frames(0),
+				m_fps(fps),
+				m_grabbed(-1),
+				m_running(false)
+{
+	for (int s = 0; s < AHEAD; ++s)
+	{
+		m_slots[s].state = SLOT_FREE;
+		m_slots[s].number = -1;
+	}
+}
+
+ImageSequenceSource::~ImageSequenceSource()
+{
+	stop();
+}
+
+/**
+ * Let the workers finish their decodes and join them
+ */
+void ImageSequenceSource::stop()
+{
+	m_running = false;
+	for (size_t w = 0; w < m_workers.size(); ++w)
+		m_workers[w].join();
+	m_workers.clear();
+}
+
+/**
+ * Worker loop: decode the earliest queued frame into its slot's image. The
+ * codecs allocate internally, which happens outside the processing loop, so
+ * these threads don't count towards the allocation counter.
+ */
+void ImageSequenceSource::decode()
+{
+	AllocationCounter::excludeThread();
+
+	vector<uchar> data;                      // Encoded file, reused
+	char filename[4096];
+
+	while (m_running)
+	{
+		Slot* claimed = NULL;
+		int earliest = INT_MAX;
+		for (int s = 0; s < AHEAD; ++s)
+		{
+			const int number = m_slots[s].number;
+			if (m_slots[s].state == SLOT_QUEUED && number < earliest)
+			{
+				claimed = &m_slots[s];
+				earliest = number;
+			}
+		}
+
+		int queued = SLOT_QUEUED;
+		if (claimed == NULL || !claimed->state.compare_exchange_strong(queued, SLOT_DECODING))
+		{
+			if (claimed == NULL) backoff();
+			continue;
+		}
+
+		snprintf(filename, sizeof(filename), m_pattern.c_str(), claimed->number.load());
+		const bool decoded = readFile(filename, data) && !imdecode(data, IMREAD_COLOR, &claimed->image).empty()
+				&& claimed->image.size() == m_size;
+		claimed->state = decoded ? SLOT_READY : SLOT_FAILED;
+	}
+}
+
+/**
+ * File name of the given frame
+ */
+string ImageSequenceSource::getFilename(
+		int frame_number) const
+{
+	char filename[4096];
+	snprintf(filename, sizeof(filename), m_pattern.c_str(), frame_number);
+	return filename;
+}
+
+/**
+ * Open the image sequence with the given file name pattern (e.g. "frames/%05d.png"),
+ * the frames run up to the first missing number
+ */
+bool ImageSequenceSource::open(
+		const string &pattern)
+{
+	stop();
+	m_pattern = pattern;
+	m_frames = 0;
+	while (General::fexists(getFilename((int) m_frames)))
+		++m_frames;
+	if (m_frames == 0) return false;
+
+	const Mat first = imread(getFilename(0));
+	if (first.type() != CV_8UC3) return false;
+	m_size = first.size();
+	m_position = 0;
+
+	for (int s = 0; s < AHEAD; ++s)
+	{
+		m_slots[s].image.create(m_size, CV_8UC3);
+		m_slots[s].number = -1;
+		m_slots[s].state = SLOT_FREE;
+	}
+	m_grabbed = -1;
+
+	m_running = true;
+	for (int w = 0; w < WORKERS; ++w)
+		m_workers.push_back(thread(&ImageSequenceSource::decode, this));
+
+	return true;
+}
+
+/**
+ * Take the frame at the current position from its slot, and queue the frames
+ * after it for the workers
+ */
+bool ImageSequenceSource::grab()
+{
+	m_grabbed = -1;
+	if (m_position < 0 || (size_t) m_position >= m_frames) return false;
+
+	const int last = std::min(m_position + AHEAD, (int) m_frames);
+	for (int n = m_position; n < last; ++n)
+	{
+		Slot &slot = m_slots[n % AHEAD];
+		if (slot.number == n && slot.state != SLOT_FREE) continue;
+
+		// A frame from before a seek: cancel it if it didn't start, else let it finish
+		int queued = SLOT_QUEUED;
+		if (!slot.state.compare_exchange_strong(queued, SLOT_FREE))
+			while (slot.state == SLOT_DECODING)
+				backoff();
+
+		slot.number = n;
+		slot.state = SLOT_QUEUED;
+	}
+
+	const int s = m_position % AHEAD;
+	int state;
+	while ((state = m_slots[s].state) == SLOT_QUEUED || state == SLOT_DECODING)
+		backoff();
+	++m_position;
+
+	if (state != SLOT_READY) return false;
+	m_grabbed = s;
+	return true;
+}
+
+/**
+ * Copy the frame grabbed last into the given image (reusing its buffer)
+ */
+bool ImageSequenceSource::retrieve(
+		Mat &frame)
+{
+	if (m_grabbed < 0) return false;
+	m_slots[m_grabbed].image.copyTo(frame);
+	return true;
+}
+
+bool ImageSequenceSource::seek(
+		int frame_number)
+{
+	m_position = frame_number;
+	return frame_number >= 0 && (size_t) frame_number < m_frames;
+}
+
+} /* namespace nl_uu_science_gmt */
@@ -0,0 +1,105 @@
+/*
+ * ImageSequenceSource.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#ifndef IMAGESEQUENCESOURCE_H_
+#define IMAGESEQUENCESOURCE_H_
+
+#include <opencv2/core/core.hpp>
+#include <stddef.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "FrameSource.h"
+
+namespace nl_uu_science_gmt
+{
+
+/*
+ * Frames read from numbered image files (printf pattern, numbered from 0)
+ * Every image decodes on its own, so WORKERS background threads decode the
+ * next AHEAD frames into the preallocated images of their slots while the
+ * current one is used. A seek only redirects the decodes that are still to be
+ * started.
+ */
+class ImageSequenceSource : public FrameSource
+{
+	// Frames decoding ahead of the position
+	static const int AHEAD = 8;
+	// Background decode threads
+	static const int WORKERS = 2;
+
+	enum SlotState
+	{
+		SLOT_FREE, SLOT_QUEUED, SLOT_DECODING, SLOT_READY, SLOT_FAILED
+	};
+
+	/*
+	 * Frame decoding in the background
+	 */
+	struct Slot
+	{
+		std::atomic<int> state;              // SlotState
+		std::atomic<int> number;             // Frame number, -1 if none
+		cv::Mat image;                       // Decoded image, allocated once
+	};
+
+	std::string m_pattern;                   // File name pattern
+	size_t m_frames;                         // Amount of frames
+	cv::Size m_size;                         // Frame size
+	double m_fps;                            // Frame rate, for the timestamps
+
+	Slot m_slots[AHEAD];                     // Frame n decodes in slot n % AHEAD
+	int m_grabbed;                           // Slot of the frame grabbed last, -1 if none
+
+	std::atomic<bool> m_running;             // Workers keep running
+	std::vector<std::thread> m_workers;      // Decode threads
+
+	std::string getFilename(
+			int) const;
+	void decode();
+	void stop();
+
+public:
+	ImageSequenceSource(
+			double);
+	virtual ~ImageSequenceSource();
+
+	bool open(
+			const std::string &);
+
+	bool grab();
+	bool retrieve(
+			cv::Mat &);
+	bool seek(
+			int);
+
+	size_t getFrameAmount() const
+	{
+		return m_frames;
+	}
+
+	cv::Size getSize() const
+	{
+		return m_size;
+	}
+
+	double getTimestamp(
+			int frame) const
+	{
+		return 1000.0 * frame / m_fps;
+	}
+
+	const char* getName() const
+	{
+		return "image sequence";
+	}
+};
+
+} /* namespace nl_uu_science_gmt */
+
+#endif /* IMAGESEQUENCESOURCE_H_ */
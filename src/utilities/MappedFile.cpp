@@ -0,0 +1,112 @@
+/*
+ * MappedFile.cpp
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace nl_uu_science_gmt
+{
+
+MappedFile::MappedFile() :
+		m_data(NULL),
+		m_size(0)
+#ifdef _WIN32
+		, m_file(NULL),
+		m_mapping(NULL)
+#endif
+{
+}
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+/**
+ * Map the given file read-only, returns false if it can't be opened or is empty
+ */
+bool MappedFile::open(
+		const string &filename)
+{
+	close();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE) return false;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	const void* data = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+	if (data == NULL)
+	{
+		if (mapping) CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+
+	m_file = file;
+	m_mapping = mapping;
+	m_size = (size_t) size.QuadPart;
+#else
+	const int fd = ::open(filename.c_str(), O_RDONLY);
+	if (fd < 0) return false;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size == 0)
+	{
+		::close(fd);
+		return false;
+	}
+
+	void* data = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	::close(fd);  // the mapping keeps the file referenced
+	if (data == MAP_FAILED) return false;
+
+	m_size = (size_t) st.st_size;
+#endif
+
+	m_data = (const unsigned char*) data;
+	return true;
+}
+
+/**
+ * Unmap the file
+ */
+void MappedFile::close()
+{
+	if (m_data == NULL) return;
+
+#ifdef _WIN32
+	UnmapViewOfFile(m_data);
+	CloseHandle((HANDLE) m_mapping);
+	CloseHandle((HANDLE) m_file);
+	m_mapping = NULL;
+	m_file = NULL;
+#else
+	munmap((void*) m_data, m_size);
+#endif
+
+	m_data = NULL;
+	m_size = 0;
+}
+
+} /* namespace nl_uu_science_gmt */
@@ -0,0 +1,56 @@
+/*
+ * MappedFile.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#ifndef MAPPEDFILE_H_
+#define MAPPEDFILE_H_
+
+#include <stddef.h>
+#include <string>
+
+namespace nl_uu_science_gmt
+{
+
+/*
+ * Read-only memory mapping of a whole file
+ */
+class MappedFile
+{
+	const unsigned char* m_data;                 // Start of the mapped file
+	size_t m_size;                               // File size in bytes
+#ifdef _WIN32
+	void* m_file;                                // File handle
+	void* m_mapping;                             // File mapping handle
+#endif
+
+	MappedFile(const MappedFile &);
+	MappedFile& operator=(const MappedFile &);
+
+public:
+	MappedFile();
+	virtual ~MappedFile();
+
+	bool open(const std::string &);
+	void close();
+
+	bool isOpen() const
+	{
+		return m_data != NULL;
+	}
+
+	const unsigned char* data() const
+	{
+		return m_data;
+	}
+
+	size_t size() const
+	{
+		return m_size;
+	}
+};
+
+} /* namespace nl_uu_science_gmt */
+
+#endif /* MAPPEDFILE_H_ */
@@ -0,0 +1,114 @@
+/*
+ * Morphology.cpp
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#include "Morphology.h"
+
+#include <algorithm>
+#include <cassert>
+
+using namespace std;
+using namespace cv;
+
+namespace nl_uu_science_gmt
+{
+
+namespace
+{
+
+struct Min
+{
+	uchar operator()(
+			uchar a, uchar b) const
+	{
+		return std::min(a, b);
+	}
+};
+
+struct Max
+{
+	uchar operator()(
+			uchar a, uchar b) const
+	{
+		return std::max(a, b);
+	}
+};
+
+} /* namespace */
+
+/**
+ * Cross of the given width and height, centered at size / 2
+ */
+Morphology::Morphology(
+		int size) :
+				m_size(size),
+				m_anchor(size / 2)
+{
+	assert(size > 0);
+}
+
+/**
+ * Apply op over the horizontal and the vertical bar of the cross. Pixels
+ * outside the image are left out (the default border of cv::erode/dilate).
+ */
+template<typename Op>
+void Morphology::filter(
+		const Mat &src, Mat &dst) const
+{
+	assert(src.type() == CV_8U && src.data != dst.data);
+	dst.create(src.size(), CV_8U);
+
+	const Op op;
+	const int width = src.cols;
+	const int height = src.rows;
+
+	int y;
+#pragma omp parallel for schedule(static) private(y)
+	for (y = 0; y < height; ++y)
+	{
+		const uchar* row = src.ptr(y);
+		uchar* out = dst.ptr(y);
+
+		// Horizontal bar
+		for (int x = 0; x < width; ++x)
+		{
+			const int x1 = std::min(width, x - m_anchor + m_size);
+			uchar value = row[std::max(0, x - m_anchor)];
+			for (int xk = std::max(0, x - m_anchor) + 1; xk < x1; ++xk)
+				value = op(value, row[xk]);
+			out[x] = value;
+		}
+
+		// Vertical bar
+		const int y1 = std::min(height, y - m_anchor + m_size);
+		for (int yk = std::max(0, y - m_anchor); yk < y1; ++yk)
+		{
+			if (yk == y) continue;
+			const uchar* bar = src.ptr(yk);
+			for (int x = 0; x < width; ++x)
+				out[x] = op(out[x], bar[x]);
+		}
+	}
+}
+
+/**
+ * dst = minimum of src over the cross around each pixel
+ */
+void Morphology::erode(
+		const Mat &src, Mat &dst) const
+{
+	filter<Min>(src, dst);
+}
+
+/**
+ * dst = maximum of src over the cross around each pixel
+ */
+void Morphology::dilate(
+		const Mat &src, Mat &dst) const
+{
+	filter<Max>(src, dst);
+}
+
+} /* namespace nl_uu_science_gmt */
@@ -0,0 +1,46 @@
+/*
+ * Morphology.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#ifndef MORPHOLOGY_H_
+#define MORPHOLOGY_H_
+
+#include <opencv2/core/core.hpp>
+
+namespace nl_uu_science_gmt
+{
+
+/*
+ * Erosion and dilation of 8-bit images with a cross-shaped structuring element
+ * Same results as cv::erode / cv::dilate with getStructuringElement(MORPH_CROSS, size)
+ * and the default anchor and border, but without allocating per call.
+ */
+class Morphology
+{
+	const int m_size;                      // Structuring element width and height
+	const int m_anchor;                    // Structuring element center
+
+	template<typename Op>
+	void filter(
+			const cv::Mat &, cv::Mat &) const;
+
+public:
+	Morphology(
+			int);
+
+	void erode(
+			const cv::Mat &, cv::Mat &) const;
+	void dilate(
+			const cv::Mat &, cv::Mat &) const;
+
+	int getSize() const
+	{
+		return m_size;
+	}
+};
+
+} /* namespace nl_uu_science_gmt */
+
+#endif /* MORPHOLOGY_H_ */
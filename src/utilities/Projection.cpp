@@ -0,0 +1,212 @@
+/*
+ * Projection.cpp
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#include "Projection.h"
+
+#include <opencv2/calib3d/calib3d.hpp>
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#include "General.h"
+
+#ifdef HAVE_X86_SIMD
+#include <immintrin.h>
+#endif
+
+using namespace std;
+using namespace cv;
+
+namespace nl_uu_science_gmt
+{
+
+namespace
+{
+
+/*
+ * Project one point, the reference for the vectorized kernel
+ */
+inline Point2f projectScalar(
+		const float* m, const Point3f &point)
+{
+	const float xc = m[Projection::R11] * point.x + m[Projection::R12] * point.y + m[Projection::R13] * point.z + m[Projection::TX];
+	const float yc = m[Projection::R21] * point.x + m[Projection::R22] * point.y + m[Projection::R23] * point.z + m[Projection::TY];
+	const float zc = m[Projection::R31] * point.x + m[Projection::R32] * point.y + m[Projection::R33] * point.z + m[Projection::TZ];
+
+	// Like cv::projectPoints, a point in the camera plane is not divided
+	const float iz = zc != 0 ? 1.f / zc : 1.f;
+	const float x = xc * iz;
+	const float y = yc * iz;
+
+	const float r2 = x * x + y * y;
+	const float radial = 1 + r2 * (m[Projection::K1] + r2 * (m[Projection::K2] + r2 * m[Projection::K3]));
+	const float xy2 = 2 * x * y;
+	const float xd = x * radial + m[Projection::P1] * xy2 + m[Projection::P2] * (r2 + 2 * x * x);
+	const float yd = y * radial + m[Projection::P1] * (r2 + 2 * y * y) + m[Projection::P2] * xy2;
+
+	return Point2f(m[Projection::FX] * xd + m[Projection::CX], m[Projection::FY] * yd + m[Projection::CY]);
+}
+
+#ifdef HAVE_X86_SIMD
+/*
+ * Project 8 points per iteration, the remainder with the scalar kernel
+ */
+TARGET_AVX2_FMA void projectAVX2(
+		const float* m, const Point3f* points, Point2f* projections, size_t amount)
+{
+	const __m256 r11 = _mm256_set1_ps(m[Projection::R11]), r12 = _mm256_set1_ps(m[Projection::R12]), r13 = _mm256_set1_ps(
+			m[Projection::R13]);
+	const __m256 r21 = _mm256_set1_ps(m[Projection::R21]), r22 = _mm256_set1_ps(m[Projection::R22]), r23 = _mm256_set1_ps(
+			m[Projection::R23]);
+	const __m256 r31 = _mm256_set1_ps(m[Projection::R31]), r32 = _mm256_set1_ps(m[Projection::R32]), r33 = _mm256_set1_ps(
+			m[Projection::R33]);
+	const __m256 tx = _mm256_set1_ps(m[Projection::TX]), ty = _mm256_set1_ps(m[Projection::TY]), tz = _mm256_set1_ps(m[Projection::TZ]);
+	const __m256 fx = _mm256_set1_ps(m[Projection::FX]), fy = _mm256_set1_ps(m[Projection::FY]);
+	const __m256 cx = _mm256_set1_ps(m[Projection::CX]), cy = _mm256_set1_ps(m[Projection::CY]);
+	const __m256 k1 = _mm256_set1_ps(m[Projection::K1]), k2 = _mm256_set1_ps(m[Projection::K2]), k3 = _mm256_set1_ps(m[Projection::K3]);
+	const __m256 p1 = _mm256_set1_ps(m[Projection::P1]), p2 = _mm256_set1_ps(m[Projection::P2]);
+	const __m256 one = _mm256_set1_ps(1.f), two = _mm256_set1_ps(2.f), zero = _mm256_setzero_ps();
+
+	// Point3f is x, y, z interleaved: gather every third float
+	const __m256i stride = _mm256_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21);
+
+	size_t i = 0;
+	for (; i + 8 <= amount; i += 8)
+	{
+		const float* p = &points[i].x;
+		const __m256 X = _mm256_i32gather_ps(p, stride, 4);
+		const __m256 Y = _mm256_i32gather_ps(p + 1, stride, 4);
+		const __m256 Z = _mm256_i32gather_ps(p + 2, stride, 4);
+
+		const __m256 xc = _mm256_fmadd_ps(r11, X, _mm256_fmadd_ps(r12, Y, _mm256_fmadd_ps(r13, Z, tx)));
+		const __m256 yc = _mm256_fmadd_ps(r21, X, _mm256_fmadd_ps(r22, Y, _mm256_fmadd_ps(r23, Z, ty)));
+		const __m256 zc = _mm256_fmadd_ps(r31, X, _mm256_fmadd_ps(r32, Y, _mm256_fmadd_ps(r33, Z, tz)));
+
+		const __m256 in_plane = _mm256_cmp_ps(zc, zero, _CMP_EQ_OQ);
+		const __m256 iz = _mm256_blendv_ps(_mm256_div_ps(one, zc), one, in_plane);
+		const __m256 x = _mm256_mul_ps(xc, iz);
+		const __m256 y = _mm256_mul_ps(yc, iz);
+
+		const __m256 xx = _mm256_mul_ps(x, x);
+		const __m256 yy = _mm256_mul_ps(y, y);
+		const __m256 r2 = _mm256_add_ps(xx, yy);
+		const __m256 radial = _mm256_fmadd_ps(r2, _mm256_fmadd_ps(r2, _mm256_fmadd_ps(r2, k3, k2), k1), one);
+		const __m256 xy2 = _mm256_mul_ps(two, _mm256_mul_ps(x, y));
+		const __m256 xd = _mm256_fmadd_ps(x, radial,
+				_mm256_fmadd_ps(p1, xy2, _mm256_mul_ps(p2, _mm256_fmadd_ps(two, xx, r2))));
+		const __m256 yd = _mm256_fmadd_ps(y, radial,
+				_mm256_fmadd_ps(p1, _mm256_fmadd_ps(two, yy, r2), _mm256_mul_ps(p2, xy2)));
+
+		const __m256 u = _mm256_fmadd_ps(fx, xd, cx);
+		const __m256 v = _mm256_fmadd_ps(fy, yd, cy);
+
+		// Interleave to u0 v0 u1 v1 ...
+		const __m256 lo = _mm256_unpacklo_ps(u, v);  // 0 1 | 4 5
+		const __m256 hi = _mm256_unpackhi_ps(u, v);  // 2 3 | 6 7
+		_mm256_storeu_ps(&projections[i].x, _mm256_permute2f128_ps(lo, hi, 0x20));
+		_mm256_storeu_ps(&projections[i + 4].x, _mm256_permute2f128_ps(lo, hi, 0x31));
+	}
+
+	for (; i < amount; ++i)
+		projections[i] = projectScalar(m, points[i]);
+}
+#endif
+
+} /* namespace */
+
+Projection::Projection() :
+		m_valid(false)
+{
+	fill(m_parameters, m_parameters + PARAMETERS, 0.f);
+}
+
+/**
+ * Set the model from the same rotation vector, translation vector, camera matrix
+ * and distortion coefficients cv::projectPoints takes. Returns false (and the model
+ * stays invalid) for a distortion model beyond k1, k2, p1, p2, k3.
+ */
+bool Projection::set(
+		const Mat &rotation_values, const Mat &translation_values, const Mat &camera_matrix, const Mat &distortion_coeffs)
+{
+	m_valid = false;
+
+	Mat rotation_d, rotation, translation, camera, distortion;
+	rotation_values.convertTo(rotation_d, CV_64F);
+	Rodrigues(rotation_d, rotation);
+	translation_values.convertTo(translation, CV_64F);
+	camera_matrix.convertTo(camera, CV_64F);
+	distortion_coeffs.convertTo(distortion, CV_64F);
+
+	const int coeffs = (int) distortion.total();
+	for (int k = 5; k < coeffs; ++k)
+		if (distortion.at<double>(k) != 0) return false;
+
+	for (int r = 0; r < 9; ++r)
+		m_parameters[R11 + r] = (float) rotation.at<double>(r / 3, r % 3);
+	for (int t = 0; t < 3; ++t)
+		m_parameters[TX + t] = (float) translation.at<double>(t);
+
+	m_parameters[FX] = (float) camera.at<double>(0, 0);
+	m_parameters[FY] = (float) camera.at<double>(1, 1);
+	m_parameters[CX] = (float) camera.at<double>(0, 2);
+	m_parameters[CY] = (float) camera.at<double>(1, 2);
+
+	for (int k = 0; k < 5; ++k)
+		m_parameters[K1 + k] = k < coeffs ? (float) distortion.at<double>(k) : 0.f;
+
+	m_valid = true;
+	return true;
+}
+
+/**
+ * Project a batch of points from the scene space to the image coordinates
+ */
+void Projection::project(
+		const Point3f* points, Point2f* projections, size_t amount) const
+{
+	assert(m_valid);
+
+#ifdef HAVE_X86_SIMD
+	if (General::hasAVX2())
+	{
+		projectAVX2(m_parameters, points, projections, amount);
+		return;
+	}
+#endif
+
+	for (size_t i = 0; i < amount; ++i)
+		projections[i] = projectScalar(m_parameters, points[i]);
+}
+
+/**
+ * Project a point from the scene space to the image coordinates
+ */
+Point2f Projection::project(
+		const Point3f &point) const
+{
+	assert(m_valid);
+	return projectScalar(m_parameters, point);
+}
+
+/**
+ * Largest distance (pixels) between this model's and cv::projectPoints' projections
+ * of the given points with the given camera
+ */
+double Projection::compare(
+		const Mat &rotation_values, const Mat &translation_values, const Mat &camera_matrix, const Mat &distortion_coeffs,
+		const vector<Point3f> &points) const
+{
+	vector<Point2f> reference, projections(points.size());
+	projectPoints(points, rotation_values, translation_values, camera_matrix, distortion_coeffs, reference);
+	project(points.data(), projections.data(), points.size());
+
+	double error = 0;
+	for (size_t p = 0; p < points.size(); ++p)
+		error = max(error, (double) hypot(reference[p].x - projections[p].x, reference[p].y - projections[p].y));
+	return error;
+}
+
+} /* namespace nl_uu_science_gmt */
@@ -0,0 +1,61 @@
+/*
+ * Projection.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#ifndef PROJECTION_H_
+#define PROJECTION_H_
+
+#include <opencv2/core/core.hpp>
+#include <stddef.h>
+#include <vector>
+
+namespace nl_uu_science_gmt
+{
+
+/*
+ * Pinhole camera projection with the 5 coefficient (k1, k2, p1, p2, k3) distortion
+ * model of cv::projectPoints, in single precision. Batches run 8 points per
+ * instruction with AVX2+FMA when the CPU has it, or in plain scalar code.
+ */
+class Projection
+{
+public:
+	// Model parameter indices
+	enum
+	{
+		R11, R12, R13, R21, R22, R23, R31, R32, R33,   // Rotation matrix
+		TX, TY, TZ,                                    // Translation
+		FX, FY, CX, CY,                                // Focal length and principal point
+		K1, K2, P1, P2, K3,                            // Distortion
+		PARAMETERS
+	};
+
+private:
+	float m_parameters[PARAMETERS];                // Model parameters
+	bool m_valid;                                  // Set from a supported camera model
+
+public:
+	Projection();
+
+	bool set(
+			const cv::Mat &, const cv::Mat &, const cv::Mat &, const cv::Mat &);
+
+	void project(
+			const cv::Point3f*, cv::Point2f*, size_t) const;
+	cv::Point2f project(
+			const cv::Point3f &) const;
+
+	double compare(
+			const cv::Mat &, const cv::Mat &, const cv::Mat &, const cv::Mat &, const std::vector<cv::Point3f> &) const;
+
+	bool isValid() const
+	{
+		return m_valid;
+	}
+};
+
+} /* namespace nl_uu_science_gmt */
+
+#endif /* PROJECTION_H_ */
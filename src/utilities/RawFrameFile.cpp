@@ -0,0 +1,197 @@
+/*
+ * RawFrameFile.cpp
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#include "RawFrameFile.h"
+
+#include <opencv2/highgui/highgui.hpp>
+#include <stdint.h>
+#include <string.h>
+#include <cstdio>
+#include <fstream>
+#include <vector>
+
+#include "General.h"
+
+using namespace std;
+using namespace cv;
+
+namespace nl_uu_science_gmt
+{
+
+namespace
+{
+
+const char RAW_MAGIC[8] = { 'V', 'R', 'R', 'A', 'W', 'F', 'R', 'M' };
+const uint32_t RAW_VERSION = 2;
+
+// Frames start on page boundaries
+const size_t PAGE = 4096;
+
+/*
+ * Frame file header, padded to a page, followed by the frames at a fixed stride
+ */
+struct RawHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t header_size;
+	uint64_t video_size;           // Size of the video file the frames were decoded from
+	int64_t video_mtime;           // Modification time of that video file
+	uint64_t frames;
+	int32_t width;
+	int32_t height;
+	int32_t type;
+	uint32_t reserved;
+	uint64_t stride;
+	uint64_t data_offset;
+	double fps;                    // Frame rate of the video
+};
+
+inline size_t pageAlign(
+		size_t bytes)
+{
+	return (bytes + PAGE - 1) / PAGE * PAGE;
+}
+
+} /* namespace */
+
+RawFrameFile::RawFrameFile() :
+		m_frames(0),
+		m_type(0),
+		m_fps(0),
+		m_stride(0),
+		m_data_offset(0)
+{
+}
+
+RawFrameFile::~RawFrameFile()
+{
+}
+
+/**
+ * Decode up to the given amount of frames of a video into a frame file,
+ * written next to it first and renamed when complete
+ */
+bool RawFrameFile::write(
+		const string &filename, const string &video, size_t frames)
+{
+	RawHeader header;
+	memset(&header, 0, sizeof(header));
+	if (!General::fileStamp(video, header.video_size, header.video_mtime)) return false;
+
+	VideoCapture capture(video);
+	if (!capture.isOpened()) return false;
+
+	const string partial = filename + ".partial";
+	ofstream file(partial.c_str(), ios::binary | ios::trunc);
+	if (!file.is_open()) return false;
+
+	// The header goes in last, when the amount of frames is known
+	const vector<char> padding(PAGE, 0);
+	file.write(padding.data(), PAGE);
+
+	Mat frame;
+	size_t written = 0;
+	for (; written < frames && capture.read(frame) && frame.type() == CV_8UC3; ++written)
+	{
+		if (written == 0)
+		{
+			header.width = frame.cols;
+			header.height = frame.rows;
+			header.type = frame.type();
+			header.stride = pageAlign(frame.total() * frame.elemSize());
+		}
+		if (frame.cols != header.width || frame.rows != header.height) break;
+
+		const size_t row_bytes = frame.cols * frame.elemSize();
+		for (int y = 0; y < frame.rows; ++y)
+			file.write((const char*) frame.ptr(y), row_bytes);
+		file.write(padding.data(), header.stride - frame.rows * row_bytes);
+	}
+
+	memcpy(header.magic, RAW_MAGIC, sizeof(RAW_MAGIC));
+	header.version = RAW_VERSION;
+	header.header_size = sizeof(RawHeader);
+	header.frames = written;
+	header.data_offset = PAGE;
+	header.fps = capture.get(CAP_PROP_FPS);
+	file.seekp(0);
+	file.write((const char*) &header, sizeof(header));
+	file.close();
+
+	if (!file.good() || written == 0)
+	{
+		remove(partial.c_str());
+		return false;
+	}
+
+	remove(filename.c_str());
+	return rename(partial.c_str(), filename.c_str()) == 0;
+}
+
+/**
+ * Map a frame file, if it was decoded from the given video as it is now
+ */
+bool RawFrameFile::open(
+		const string &filename, const string &video)
+{
+	close();
+
+	uint64_t video_size;
+	int64_t video_mtime;
+	if (!General::fileStamp(video, video_size, video_mtime) || !m_file.open(filename)) return false;
+
+	RawHeader header;
+	bool valid = m_file.size() >= sizeof(header);
+	if (valid)
+	{
+		memcpy(&header, m_file.data(), sizeof(header));
+		valid = memcmp(header.magic, RAW_MAGIC, sizeof(RAW_MAGIC)) == 0 && header.version == RAW_VERSION
+				&& header.header_size == sizeof(RawHeader) && header.video_size == video_size
+				&& header.video_mtime == video_mtime && header.width > 0 && header.height > 0
+				&& header.stride >= (uint64_t) header.width * header.height * CV_ELEM_SIZE(header.type)
+				&& m_file.size() == header.data_offset + header.frames * header.stride;
+	}
+	if (!valid)
+	{
+		m_file.close();
+		return false;
+	}
+
+	m_frames = (size_t) header.frames;
+	m_size = Size(header.width, header.height);
+	m_type = header.type;
+	m_fps = header.fps;
+	m_stride = (size_t) header.stride;
+	m_data_offset = (size_t) header.data_offset;
+
+	return true;
+}
+
+/**
+ * Unmap the frame file
+ */
+void RawFrameFile::close()
+{
+	m_file.close();
+	m_frames = 0;
+}
+
+/**
+ * Point the given image at the mapped frame with the given number, false if
+ * the file doesn't have it. The image is read-only and stays valid while the
+ * file is open.
+ */
+bool RawFrameFile::getFrame(
+		int frame_number, Mat &frame) const
+{
+	if (frame_number < 0 || (size_t) frame_number >= m_frames) return false;
+
+	frame = Mat(m_size, m_type, (void*) (m_file.data() + m_data_offset + frame_number * m_stride));
+	return true;
+}
+
+} /* namespace nl_uu_science_gmt */
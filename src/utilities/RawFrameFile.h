@@ -0,0 +1,77 @@
+/*
+ * RawFrameFile.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#ifndef RAWFRAMEFILE_H_
+#define RAWFRAMEFILE_H_
+
+#include <opencv2/core/core.hpp>
+#include <stddef.h>
+#include <string>
+
+#include "MappedFile.h"
+
+namespace nl_uu_science_gmt
+{
+
+/*
+ * Decoded video frames in one uncompressed file, played back from a memory mapping
+ * Frame n lives at a fixed stride (page aligned) past the header, so finding a
+ * frame is a multiplication and handing it out is a cv::Mat header on the
+ * mapped pages: no decoding and no copy. The file is valid as long as the
+ * video it was decoded from keeps its size and modification time.
+ */
+class RawFrameFile
+{
+	MappedFile m_file;                       // Mapped frame file
+	size_t m_frames;                         // Amount of frames in the file
+	cv::Size m_size;                         // Frame size
+	int m_type;                              // Frame type
+	double m_fps;                            // Frame rate of the video
+	size_t m_stride;                         // Bytes from one frame to the next
+	size_t m_data_offset;                    // Byte offset of frame 0
+
+public:
+	RawFrameFile();
+	virtual ~RawFrameFile();
+
+	static bool write(
+			const std::string &, const std::string &, size_t);
+
+	bool open(
+			const std::string &, const std::string &);
+	void close();
+	bool getFrame(
+			int, cv::Mat &) const;
+
+	bool isOpen() const
+	{
+		return m_file.isOpen();
+	}
+
+	size_t getFrameAmount() const
+	{
+		return m_frames;
+	}
+
+	const cv::Size& getSize() const
+	{
+		return m_size;
+	}
+
+	int getType() const
+	{
+		return m_type;
+	}
+
+	double getFps() const
+	{
+		return m_fps;
+	}
+};
+
+} /* namespace nl_uu_science_gmt */
+
+#endif /* RAWFRAMEFILE_H_ */
@@ -0,0 +1,56 @@
+/*
+ * RawFrameSource.cpp
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#include "RawFrameSource.h"
+
+using namespace std;
+using namespace cv;
+
+namespace nl_uu_science_gmt
+{
+
+RawFrameSource::RawFrameSource()
+{
+}
+
+RawFrameSource::~RawFrameSource()
+{
+}
+
+/**
+ * Map the frame file, if it was decoded from the given video as it is now
+ */
+bool RawFrameSource::open(
+		const string &filename, const string &video)
+{
+	m_position = 0;
+	return m_file.open(filename, video) && m_file.getType() == CV_8UC3;
+}
+
+bool RawFrameSource::grab()
+{
+	if (m_position < 0 || (size_t) m_position >= m_file.getFrameAmount()) return false;
+	++m_position;
+	return true;
+}
+
+/**
+ * Point the given image at the mapped frame grabbed last (read-only)
+ */
+bool RawFrameSource::retrieve(
+		Mat &frame)
+{
+	return m_file.getFrame(m_position - 1, frame);
+}
+
+bool RawFrameSource::seek(
+		int frame_number)
+{
+	m_position = frame_number;
+	return frame_number >= 0 && (size_t) frame_number < m_file.getFrameAmount();
+}
+
+} /* namespace nl_uu_science_gmt */
@@ -0,0 +1,71 @@
+/*
+ * RawFrameSource.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#ifndef RAWFRAMESOURCE_H_
+#define RAWFRAMESOURCE_H_
+
+#include <opencv2/core/core.hpp>
+#include <stddef.h>
+#include <string>
+
+#include "FrameSource.h"
+#include "RawFrameFile.h"
+
+namespace nl_uu_science_gmt
+{
+
+/*
+ * Pre-decoded frames played back from a mapped RawFrameFile
+ * Seeking and grabbing only move the position, retrieving points the image at
+ * the mapped frame: no decoding and no copy.
+ */
+class RawFrameSource : public FrameSource
+{
+	RawFrameFile m_file;                     // Mapped frame file
+
+public:
+	RawFrameSource();
+	virtual ~RawFrameSource();
+
+	bool open(
+			const std::string &, const std::string &);
+
+	bool grab();
+	bool retrieve(
+			cv::Mat &);
+	bool seek(
+			int);
+
+	size_t getFrameAmount() const
+	{
+		return m_file.getFrameAmount();
+	}
+
+	cv::Size getSize() const
+	{
+		return m_file.getSize();
+	}
+
+	double getTimestamp(
+			int frame) const
+	{
+		return m_file.getFps() > 0 ? 1000.0 * frame / m_file.getFps() : 0;
+	}
+
+	const char* getName() const
+	{
+		return "raw frames";
+	}
+
+	bool isZeroCopy() const
+	{
+		return true;
+	}
+};
+
+} /* namespace nl_uu_science_gmt */
+
+#endif /* RAWFRAMESOURCE_H_ */
@@ -0,0 +1,80 @@
+/*
+ * SpscQueue.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#ifndef SPSCQUEUE_H_
+#define SPSCQUEUE_H_
+
+#include <atomic>
+#include <cassert>
+#include <stddef.h>
+#include <vector>
+
+namespace nl_uu_science_gmt
+{
+
+/*
+ * Bounded lock-free single-producer single-consumer queue
+ * One thread pushes and one other thread pops. The capacity is a power of two,
+ * a full queue refuses a push so the producer can hold back (backpressure).
+ */
+template<typename T>
+class SpscQueue
+{
+	std::vector<T> m_items;                  // Ring buffer
+	const size_t m_mask;                     // Capacity - 1
+
+	std::atomic<size_t> m_head;              // Items popped (written by the consumer only)
+	char m_padding[64];                      // Keep head and tail on their own cache lines
+	std::atomic<size_t> m_tail;              // Items pushed (written by the producer only)
+
+public:
+	explicit SpscQueue(
+			size_t capacity) :
+					m_items(capacity),
+					m_mask(capacity - 1),
+					m_head(0),
+					m_tail(0)
+	{
+		assert(capacity > 0 && (capacity & m_mask) == 0);
+	}
+
+	/*
+	 * Append an item, false if the queue is full (producer only)
+	 */
+	bool push(
+			const T &item)
+	{
+		const size_t tail = m_tail.load(std::memory_order_relaxed);
+		if (tail - m_head.load(std::memory_order_acquire) == m_items.size()) return false;
+
+		m_items[tail & m_mask] = item;
+		m_tail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	/*
+	 * Take the oldest item, false if the queue is empty (consumer only)
+	 */
+	bool pop(
+			T &item)
+	{
+		const size_t head = m_head.load(std::memory_order_relaxed);
+		if (m_tail.load(std::memory_order_acquire) == head) return false;
+
+		item = m_items[head & m_mask];
+		m_head.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	size_t capacity() const
+	{
+		return m_items.size();
+	}
+};
+
+} /* namespace nl_uu_science_gmt */
+
+#endif /* SPSCQUEUE_H_ */
@@ -0,0 +1,67 @@
+/*
+ * SyntheticFrameSource.cpp
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#include "SyntheticFrameSource.h"
+
+#include <opencv2/imgproc/imgproc.hpp>
+#include <algorithm>
+
+using namespace std;
+using namespace cv;
+
+namespace nl_uu_science_gmt
+{
+
+const size_t SyntheticFrameSource::DEFAULT_FRAMES;
+
+SyntheticFrameSource::SyntheticFrameSource(
+		const Mat &background, size_t frames, double fps) :
+				m_background(background.clone()),
+				m_frames(frames),
+				m_fps(fps)
+{
+}
+
+SyntheticFrameSource::~SyntheticFrameSource()
+{
+}
+
+bool SyntheticFrameSource::grab()
+{
+	if (m_position < 0 || (size_t) m_position >= m_frames) return false;
+	++m_position;
+	return true;
+}
+
+/**
+ * Draw the frame grabbed last into the given image (reusing its buffer): a
+ * block of 1/8 by 1/3 of the frame that bounces from side to side
+ */
+bool SyntheticFrameSource::retrieve(
+		Mat &frame)
+{
+	const int frame_number = m_position - 1;
+	if (frame_number < 0) return false;
+
+	m_background.copyTo(frame);
+
+	const Size block(frame.cols / 8, frame.rows / 3);
+	const int range = std::max(1, frame.cols - block.width);
+	const int step = 4 * frame_number % (2 * range);
+	const Point corner(step < range ? step : 2 * range - step, (frame.rows - block.height) / 2);
+	rectangle(frame, Rect(corner, block), Scalar(40, 40, 200), -1);
+
+	return true;
+}
+
+bool SyntheticFrameSource::seek(
+		int frame_number)
+{
+	m_position = frame_number;
+	return frame_number >= 0 && (size_t) frame_number < m_frames;
+}
+
+} /* namespace nl_uu_science_gmt */
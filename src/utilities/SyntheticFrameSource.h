@@ -0,0 +1,66 @@
+/*
+ * SyntheticFrameSource.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#ifndef SYNTHETICFRAMESOURCE_H_
+#define SYNTHETICFRAMESOURCE_H_
+
+#include <opencv2/core/core.hpp>
+#include <stddef.h>
+
+#include "FrameSource.h"
+
+namespace nl_uu_science_gmt
+{
+
+/*
+ * Generated frames: the background image with a block moving across it
+ * No file and no codec involved, to measure the rest of the pipeline on its own.
+ */
+class SyntheticFrameSource : public FrameSource
+{
+	const cv::Mat m_background;              // Background image
+	const size_t m_frames;                   // Amount of frames
+	const double m_fps;                      // Frame rate, for the timestamps
+
+public:
+	// Frames generated when no amount is given
+	static const size_t DEFAULT_FRAMES = 500;
+
+	SyntheticFrameSource(
+			const cv::Mat &, size_t, double);
+	virtual ~SyntheticFrameSource();
+
+	bool grab();
+	bool retrieve(
+			cv::Mat &);
+	bool seek(
+			int);
+
+	size_t getFrameAmount() const
+	{
+		return m_frames;
+	}
+
+	cv::Size getSize() const
+	{
+		return m_background.size();
+	}
+
+	double getTimestamp(
+			int frame) const
+	{
+		return 1000.0 * frame / m_fps;
+	}
+
+	const char* getName() const
+	{
+		return "synthetic";
+	}
+};
+
+} /* namespace nl_uu_science_gmt */
+
+#endif /* SYNTHETICFRAMESOURCE_H_ */
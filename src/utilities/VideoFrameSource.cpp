@@ -0,0 +1,104 @@
+/*
+ * VideoFrameSource.cpp
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#include "VideoFrameSource.h"
+
+#include <iostream>
+
+using namespace std;
+using namespace cv;
+
+namespace nl_uu_science_gmt
+{
+
+VideoFrameSource::VideoFrameSource()
+{
+}
+
+VideoFrameSource::~VideoFrameSource()
+{
+}
+
+/**
+ * Open the given video, with its index from the given sidecar file, or probed
+ * from the container index once and written to that file
+ */
+bool VideoFrameSource::open(
+		const string &video_file, const string &index_file)
+{
+	m_video = VideoCapture(video_file);
+	if (!m_video.isOpened()) return false;
+
+	m_size.width = (int) m_video.get(CAP_PROP_FRAME_WIDTH);
+	m_size.height = (int) m_video.get(CAP_PROP_FRAME_HEIGHT);
+
+	if (!m_index.load(index_file, video_file))
+	{
+		if (!m_index.probe(video_file))
+		{
+			// No container index: count the frames by going to the end of the video
+			m_video.set(CAP_PROP_POS_AVI_RATIO, 1);  // 1 = 100%
+			m_index.set((size_t) m_video.get(CAP_PROP_POS_FRAMES), m_video.get(CAP_PROP_FPS));
+
+			m_video.release(); //Re-open the file because _video.set(CV_CAP_PROP_POS_AVI_RATIO, 1) may screw it up
+			m_video = VideoCapture(video_file);
+		}
+		if (!m_index.save(index_file, video_file)) cerr << "Unable to write: " << index_file << endl;
+	}
+	m_position = 0;
+
+	return m_size.area() > 0 && m_index.getFrameAmount() > 0;
+}
+
+/**
+ * Decode the frame at the current position without converting it
+ */
+bool VideoFrameSource::grab()
+{
+	if (!m_video.grab()) return false;
+	++m_position;
+	return true;
+}
+
+/**
+ * Convert the frame grabbed last into the given image (reusing its buffer)
+ */
+bool VideoFrameSource::retrieve(
+		Mat &frame)
+{
+	return m_video.retrieve(frame) && !frame.empty();
+}
+
+/**
+ * Put the video reader at the given frame: seek to the nearest keyframe at or
+ * before it, unless the reader is already between that keyframe and the frame,
+ * and grab (decode without converting) the frames in between
+ */
+bool VideoFrameSource::seek(
+		int frame_number)
+{
+	if (frame_number == m_position) return true;
+
+	const int keyframe = m_index.getKeyframeBefore(frame_number);
+	if (keyframe < 0)
+	{
+		// Keyframes unknown, leave it to the video reader
+		m_position = frame_number;
+		return m_video.set(CAP_PROP_POS_FRAMES, frame_number);
+	}
+
+	if (m_position > frame_number || m_position < keyframe)
+	{
+		if (!m_video.set(CAP_PROP_POS_FRAMES, keyframe)) return false;
+		m_position = keyframe;
+	}
+	while (m_position < frame_number)
+		if (!grab()) return false;
+
+	return true;
+}
+
+} /* namespace nl_uu_science_gmt */
@@ -0,0 +1,75 @@
+/*
+ * VideoFrameSource.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#ifndef VIDEOFRAMESOURCE_H_
+#define VIDEOFRAMESOURCE_H_
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/highgui/highgui.hpp>
+#include <stddef.h>
+#include <string>
+
+#include "FrameSource.h"
+#include "VideoIndex.h"
+
+namespace nl_uu_science_gmt
+{
+
+/*
+ * Frames decoded from a video file with cv::VideoCapture
+ * The frame count, timing and keyframes come from the video's index. A seek
+ * goes to the nearest keyframe at or before the frame and grabs forward, or
+ * only grabs forward when the reader is already between the two.
+ */
+class VideoFrameSource : public FrameSource
+{
+	cv::VideoCapture m_video;                // Video reader
+	VideoIndex m_index;                      // Frame count, timing and keyframes of the video
+	cv::Size m_size;                         // Frame size
+
+public:
+	VideoFrameSource();
+	virtual ~VideoFrameSource();
+
+	bool open(
+			const std::string &, const std::string &);
+
+	bool grab();
+	bool retrieve(
+			cv::Mat &);
+	bool seek(
+			int);
+
+	size_t getFrameAmount() const
+	{
+		return m_index.getFrameAmount();
+	}
+
+	cv::Size getSize() const
+	{
+		return m_size;
+	}
+
+	double getTimestamp(
+			int frame) const
+	{
+		return m_index.getTimestamp(frame);
+	}
+
+	const char* getName() const
+	{
+		return "video";
+	}
+
+	const VideoIndex& getIndex() const
+	{
+		return m_index;
+	}
+};
+
+} /* namespace nl_uu_science_gmt */
+
+#endif /* VIDEOFRAMESOURCE_H_ */
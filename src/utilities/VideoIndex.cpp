@@ -0,0 +1,347 @@
+/*
+ * VideoIndex.cpp
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#include "VideoIndex.h"
+
+#include <string.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+
+#include "General.h"
+#include "MappedFile.h"
+
+using namespace std;
+
+namespace nl_uu_science_gmt
+{
+
+namespace
+{
+
+const char INDEX_MAGIC[8] = { 'V', 'R', 'V', 'I', 'D', 'I', 'D', 'X' };
+const uint32_t INDEX_VERSION = 3;
+
+/*
+ * Sidecar index file header, followed by the keyframe numbers (int32)
+ */
+struct IndexHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t header_size;
+	uint64_t video_size;           // Size of the video file the index was probed from
+	int64_t video_mtime;           // Modification time of that video file
+	uint64_t frames;
+	uint32_t scale;
+	uint32_t rate;
+	uint32_t start;
+	uint32_t keyframes;
+};
+
+// AVI index flags and types
+const uint32_t AVIIF_KEYFRAME = 0x10;              // idx1: chunk is a keyframe
+const uint32_t AVISTDINDEX_DELTAFRAME = 0x80000000;  // ix##: chunk is not a keyframe
+const uint8_t AVI_INDEX_OF_INDEXES = 0x00;
+const uint8_t AVI_INDEX_OF_CHUNKS = 0x01;
+
+/*
+ * Little endian integers at p (AVI is little endian)
+ */
+inline uint16_t read16(
+		const unsigned char* p)
+{
+	return (uint16_t) (p[0] | p[1] << 8);
+}
+
+inline uint32_t read32(
+		const unsigned char* p)
+{
+	return (uint32_t) p[0] | (uint32_t) p[1] << 8 | (uint32_t) p[2] << 16 | (uint32_t) p[3] << 24;
+}
+
+inline uint64_t read64(
+		const unsigned char* p)
+{
+	return (uint64_t) read32(p) | (uint64_t) read32(p + 4) << 32;
+}
+
+inline bool isFourcc(
+		const unsigned char* p, const char* fourcc)
+{
+	return memcmp(p, fourcc, 4) == 0;
+}
+
+} /* namespace */
+
+VideoIndex::VideoIndex() :
+		m_frames(0),
+		m_scale(0),
+		m_rate(0),
+		m_start(0)
+{
+}
+
+VideoIndex::~VideoIndex()
+{
+}
+
+/**
+ * Read the frame count, timing and keyframes of an AVI file from its headers
+ * and index, returns false if it isn't an AVI file or has no usable index
+ */
+bool VideoIndex::probe(
+		const string &filename)
+{
+	m_frames = 0;
+	m_keyframes.clear();
+
+	MappedFile file;
+	if (!file.open(filename)) return false;
+	const unsigned char* data = file.data();
+	const size_t size = file.size();
+	if (size < 12 || !isFourcc(data, "RIFF") || !isFourcc(data + 8, "AVI ")) return false;
+
+	int stream = -1;                          // Number of the first video stream
+	size_t length = 0;                        // Frames according to its stream header
+	const unsigned char* indx = NULL;         // Its OpenDML super index
+	size_t indx_size = 0;
+	const unsigned char* idx1 = NULL;         // Legacy index of all streams
+	size_t idx1_size = 0;
+
+	// Top level chunks of the first RIFF, skipping the movie data
+	for (size_t pos = 12; pos + 8 <= size;)
+	{
+		const unsigned char* chunk = data + pos;
+		const size_t chunk_size = std::min<size_t>(read32(chunk + 4), size - pos - 8);
+
+		if (isFourcc(chunk, "LIST") && chunk_size >= 4 && isFourcc(chunk + 8, "hdrl"))
+		{
+			// Header list: avih followed by one strl list per stream
+			int streams = 0;
+			for (size_t hpos = 12; hpos + 8 <= chunk_size + 8;)
+			{
+				const unsigned char* header = chunk + hpos;
+				const size_t header_size = std::min<size_t>(read32(header + 4), chunk_size + 8 - hpos - 8);
+
+				if (isFourcc(header, "LIST") && header_size >= 4 && isFourcc(header + 8, "strl"))
+				{
+					for (size_t spos = 12; spos + 8 <= header_size + 8;)
+					{
+						const unsigned char* sub = header + spos;
+						const size_t sub_size = std::min<size_t>(read32(sub + 4), header_size + 8 - spos - 8);
+
+						if (stream < 0 && isFourcc(sub, "strh") && sub_size >= 36 && isFourcc(sub + 8, "vids"))
+						{
+							stream = streams;
+							m_scale = read32(sub + 8 + 20);
+							m_rate = read32(sub + 8 + 24);
+							m_start = read32(sub + 8 + 28);
+							length = read32(sub + 8 + 32);
+						}
+						else if (stream == streams && isFourcc(sub, "indx"))
+						{
+							indx = sub + 8;
+							indx_size = sub_size;
+						}
+						spos += 8 + sub_size + (sub_size & 1);
+					}
+					++streams;
+				}
+				hpos += 8 + header_size + (header_size & 1);
+			}
+		}
+		else if (isFourcc(chunk, "idx1"))
+		{
+			idx1 = chunk + 8;
+			idx1_size = chunk_size;
+		}
+		pos += 8 + chunk_size + (chunk_size & 1);
+	}
+	if (stream < 0 || m_scale == 0 || m_rate == 0) return false;
+
+	if (indx == NULL || !parseSuperIndex(data, size, indx, indx_size))
+	{
+		m_keyframes.clear();
+		if (idx1 == NULL || !parseLegacyIndex(idx1, idx1_size, stream))
+		{
+			// No index: trust the stream header, keyframes unknown
+			m_frames = length;
+			m_keyframes.clear();
+		}
+	}
+
+	return m_frames > 0;
+}
+
+/**
+ * Read the frames from an OpenDML super index and the standard indexes it points to
+ */
+bool VideoIndex::parseSuperIndex(
+		const unsigned char* data, size_t size, const unsigned char* indx, size_t indx_size)
+{
+	if (indx_size < 24 || indx[3] != AVI_INDEX_OF_INDEXES || read16(indx) != 4) return false;
+
+	size_t frames = 0;
+	const size_t entries = std::min<size_t>(read32(indx + 4), (indx_size - 24) / 16);
+	for (size_t e = 0; e < entries; ++e)
+	{
+		const uint64_t offset = read64(indx + 24 + 16 * e);
+		if (offset + 32 > size) return false;
+
+		// Standard index: 24 byte header, then a {data offset from the base, size} pair per chunk
+		const unsigned char* ix = data + offset;
+		const size_t ix_size = std::min<size_t>(read32(ix + 4), size - offset - 8);
+		if (ix[8 + 3] != AVI_INDEX_OF_CHUNKS || read16(ix + 8) != 2 || ix_size < 24) return false;
+
+		const size_t chunks = std::min<size_t>(read32(ix + 8 + 4), (ix_size - 24) / 8);
+		for (size_t c = 0; c < chunks; ++c)
+		{
+			const unsigned char* entry = ix + 8 + 24 + 8 * c;
+			if (!(read32(entry + 4) & AVISTDINDEX_DELTAFRAME)) m_keyframes.push_back((int) frames);
+			++frames;
+		}
+	}
+
+	m_frames = frames;
+	return frames > 0;
+}
+
+/**
+ * Read the frames of the given stream from a legacy idx1 index
+ */
+bool VideoIndex::parseLegacyIndex(
+		const unsigned char* idx1, size_t idx1_size, int stream)
+{
+	const char digits[2] = { (char) ('0' + stream / 10 % 10), (char) ('0' + stream % 10) };
+
+	size_t frames = 0;
+	for (size_t e = 0; e + 16 <= idx1_size; e += 16)
+	{
+		// Entry: chunk id, flags, chunk header offset, size; video chunks are ##dc or ##db
+		const unsigned char* entry = idx1 + e;
+		if (memcmp(entry, digits, 2) != 0 || entry[2] != 'd' || (entry[3] != 'c' && entry[3] != 'b')) continue;
+
+		if (read32(entry + 4) & AVIIF_KEYFRAME) m_keyframes.push_back((int) frames);
+		++frames;
+	}
+
+	m_frames = frames;
+	return frames > 0;
+}
+
+/**
+ * Set the frame count and rate found some other way, keyframes unknown
+ */
+void VideoIndex::set(
+		size_t frames, double fps)
+{
+	m_frames = frames;
+	m_scale = 1000;
+	m_rate = (uint32_t) floor(fps * m_scale + 0.5);
+	m_start = 0;
+	m_keyframes.clear();
+}
+
+/**
+ * Read the index from a sidecar file, if it was probed from the given video
+ * as it is now
+ */
+bool VideoIndex::load(
+		const string &filename, const string &video)
+{
+	uint64_t video_size;
+	int64_t video_mtime;
+	if (!General::fileStamp(video, video_size, video_mtime)) return false;
+
+	ifstream file(filename.c_str(), ios::binary);
+	if (!file.is_open()) return false;
+
+	IndexHeader header;
+	if (!file.read((char*) &header, sizeof(header))) return false;
+	if (memcmp(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0 || header.version != INDEX_VERSION
+			|| header.header_size != sizeof(IndexHeader) || header.video_size != video_size
+			|| header.video_mtime != video_mtime || header.frames == 0) return false;
+
+	// A corrupt keyframe count mustn't size the buffers: it can't exceed the
+	// frames, nor the keyframe data the file holds
+	file.seekg(0, ios::end);
+	const uint64_t remaining = (uint64_t) file.tellg() - sizeof(header);
+	file.seekg(sizeof(header));
+	if (header.keyframes > header.frames
+			|| remaining != (uint64_t) header.keyframes * sizeof(int)) return false;
+
+	vector<int> keyframes(header.keyframes);
+	if (!keyframes.empty() && !file.read((char*) keyframes.data(), keyframes.size() * sizeof(int))) return false;
+
+	m_frames = (size_t) header.frames;
+	m_scale = header.scale;
+	m_rate = header.rate;
+	m_start = header.start;
+	m_keyframes.swap(keyframes);
+
+	return true;
+}
+
+/**
+ * Write the index to a sidecar file, stamped with the given video's size and
+ * modification time, written next to it first and renamed when complete
+ */
+bool VideoIndex::save(
+		const string &filename, const string &video) const
+{
+	IndexHeader header;
+	memset(&header, 0, sizeof(header));
+	if (!General::fileStamp(video, header.video_size, header.video_mtime)) return false;
+
+	const string partial = filename + ".partial";
+	ofstream file(partial.c_str(), ios::binary | ios::trunc);
+	if (!file.is_open()) return false;
+
+	memcpy(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+	header.version = INDEX_VERSION;
+	header.header_size = sizeof(IndexHeader);
+	header.frames = m_frames;
+	header.scale = m_scale;
+	header.rate = m_rate;
+	header.start = m_start;
+	header.keyframes = (uint32_t) m_keyframes.size();
+
+	file.write((const char*) &header, sizeof(header));
+	file.write((const char*) m_keyframes.data(), m_keyframes.size() * sizeof(int));
+	file.close();
+
+	if (!file.good())
+	{
+		remove(partial.c_str());
+		return false;
+	}
+
+	remove(filename.c_str());
+	return rename(partial.c_str(), filename.c_str()) == 0;
+}
+
+/**
+ * Presentation time of the given frame in milliseconds
+ */
+double VideoIndex::getTimestamp(
+		int frame) const
+{
+	return m_rate > 0 ? 1000.0 * (m_start + frame) * m_scale / m_rate : 0;
+}
+
+/**
+ * The nearest keyframe at or before the given frame, -1 if the keyframes are unknown
+ */
+int VideoIndex::getKeyframeBefore(
+		int frame) const
+{
+	const vector<int>::const_iterator after = upper_bound(m_keyframes.begin(), m_keyframes.end(), frame);
+	return after == m_keyframes.begin() ? -1 : *(after - 1);
+}
+
+} /* namespace nl_uu_science_gmt */
@@ -0,0 +1,77 @@
+/*
+ * VideoIndex.h
+ *
+ *  Created on: Oct 17, 2026
+ */
+
+#ifndef VIDEOINDEX_H_
+#define VIDEOINDEX_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace nl_uu_science_gmt
+{
+
+/*
+ * Frame count, frame timing and keyframe numbers of a video
+ * Probed from the AVI container index (OpenDML indx/ix## or the legacy idx1)
+ * without decoding, and cached in a small sidecar file that's valid as long as
+ * the video's size and modification time don't change. AVI frames have a
+ * constant rate, so frame n starts at (start + n) * scale / rate seconds.
+ * Decoding can start at a keyframe, so a seek to frame n goes to the nearest
+ * keyframe at or before n and decodes forward from there.
+ */
+class VideoIndex
+{
+	size_t m_frames;                         // Amount of frames
+	uint32_t m_scale;                        // Frame duration is scale / rate seconds
+	uint32_t m_rate;
+	uint32_t m_start;                        // Start of the stream in frames
+	std::vector<int> m_keyframes;            // Frame numbers of the keyframes, ascending (empty if unknown)
+
+	bool parseSuperIndex(
+			const unsigned char*, size_t, const unsigned char*, size_t);
+	bool parseLegacyIndex(
+			const unsigned char*, size_t, int);
+
+public:
+	VideoIndex();
+	virtual ~VideoIndex();
+
+	bool probe(
+			const std::string &);
+	void set(
+			size_t, double);
+
+	bool load(
+			const std::string &, const std::string &);
+	bool save(
+			const std::string &, const std::string &) const;
+
+	double getTimestamp(
+			int) const;
+	int getKeyframeBefore(
+			int) const;
+
+	size_t getFrameAmount() const
+	{
+		return m_frames;
+	}
+
+	double getFps() const
+	{
+		return m_scale > 0 ? (double) m_rate / m_scale : 0;
+	}
+
+	const std::vector<int>& getKeyframes() const
+	{
+		return m_keyframes;
+	}
+};
+
+} /* namespace nl_uu_science_gmt */
+
+#endif /* VIDEOINDEX_H_ */